@@ -0,0 +1,356 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <atomic>
+#include <errno.h>
+#include <iostream>
+#include <stdlib.h>
+#include <string.h>
+#include <malloc.h>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QSettings>
+
+#include "comparetree.h"
+#include "graphwidget.h"
+#include "mainwindow.h"
+#include "tagtree.h"
+#include "version.h"
+
+using namespace std;
+
+// malloc is replaced, so the allocations of Qt containers and of
+// operator new are counted, too. The address sanitizer of the
+// DEBUG build replaces it itself.
+#if defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define BENCH_NO_MALLOC_COUNT
+#endif
+#endif
+#if defined(__SANITIZE_ADDRESS__) || !defined(__GLIBC__)
+#define BENCH_NO_MALLOC_COUNT
+#endif
+
+static atomic<quint64> allocations(0);
+static atomic<quint64> allocatedBytes(0);
+
+#ifndef BENCH_NO_MALLOC_COUNT
+extern "C" {
+
+void* __libc_malloc(size_t _size);
+void* __libc_calloc(size_t _count, size_t _size);
+void* __libc_realloc(void* _p, size_t _size);
+void* __libc_memalign(size_t _alignment, size_t _size);
+void __libc_free(void* _p);
+
+void* malloc(size_t _size) __THROW
+{
+    allocations++;
+    allocatedBytes += _size;
+
+    return __libc_malloc(_size);
+}
+
+void* calloc(size_t _count, size_t _size) __THROW
+{
+    allocations++;
+    allocatedBytes += _count * _size;
+
+    return __libc_calloc(_count, _size);
+}
+
+void* realloc(void* _p, size_t _size) __THROW
+{
+    allocations++;
+    allocatedBytes += _size;
+
+    return __libc_realloc(_p, _size);
+}
+
+void* memalign(size_t _alignment, size_t _size) __THROW
+{
+    allocations++;
+    allocatedBytes += _size;
+
+    return __libc_memalign(_alignment, _size);
+}
+
+void* aligned_alloc(size_t _alignment, size_t _size) __THROW
+{
+    return memalign(_alignment, _size);
+}
+
+int posix_memalign(void** _p, size_t _alignment, size_t _size) __THROW
+{
+    void* p = memalign(_alignment, _size);
+
+    if (p == NULL)
+        return ENOMEM;
+
+    *_p = p;
+
+    return 0;
+}
+
+void free(void* _p) __THROW
+{
+    __libc_free(_p);
+}
+
+}
+#endif
+
+// a value of kB of /proc/self/status, e.g. "VmRSS:", -1 if unknown
+static long statusKb(const char* _key)
+{
+    QFile file("/proc/self/status");
+
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+        return -1;
+
+    // read outside of the counted part of a phase
+    QByteArray content = file.readAll();
+    int pos = content.indexOf(_key);
+
+    if (pos == -1)
+        return -1;
+
+    return strtol(content.constData() + pos + strlen(_key), NULL, 10);
+}
+
+// the peak RSS is reset to the current RSS, false if not supported
+static bool resetPeakRss()
+{
+    QFile file("/proc/self/clear_refs");
+
+    return file.open(QFile::WriteOnly | QFile::Unbuffered) && file.write("5") == 1;
+}
+
+/**
+ * \brief Measures one phase and prints it as one line of JSON:
+ *        {"phase":..., "run":..., "wall_ms":..., "allocations":...,
+ *         "allocated_bytes":..., "rss_delta_kb":..., "peak_rss_kb":...}
+ *        The allocations are the calls of malloc and its siblings,
+ *        null if they are not counted. The RSS delta is the change of
+ *        the RSS by the phase, the peak is the peak RSS during the
+ *        phase, null if the kernel can not reset it.
+ */
+class Phase
+{
+public:
+    Phase(const char* _name, int _run) :
+        name(_name),
+        run(_run)
+    {
+        peakReset = resetPeakRss();
+        startRss = statusKb("VmRSS:");
+        startAllocations = allocations;
+        startBytes = allocatedBytes;
+        timer.start();
+    }
+
+    ~Phase()
+    {
+        qint64 ns = timer.nsecsElapsed();
+        quint64 phaseAllocations = allocations - startAllocations;
+        quint64 phaseBytes = allocatedBytes - startBytes;
+        long rss = statusKb("VmRSS:");
+        long peak = statusKb("VmHWM:");
+
+        cout << "{\"phase\":\"" << name << "\""
+             << ",\"run\":" << run
+             << ",\"wall_ms\":" << ns / 1000000.0;
+#ifndef BENCH_NO_MALLOC_COUNT
+        cout << ",\"allocations\":" << phaseAllocations
+             << ",\"allocated_bytes\":" << phaseBytes;
+#else
+        (void)phaseAllocations;
+        (void)phaseBytes;
+        cout << ",\"allocations\":null"
+             << ",\"allocated_bytes\":null";
+#endif
+        cout << ",\"rss_delta_kb\":" << rss - startRss;
+        if (peakReset && peak != -1)
+            cout << ",\"peak_rss_kb\":" << peak;
+        else
+            cout << ",\"peak_rss_kb\":null";
+        cout << "}" << endl;
+    }
+
+private:
+    const char* name;
+    int run;
+    bool peakReset;
+    long startRss;
+    quint64 startAllocations;
+    quint64 startBytes;
+    QElapsedTimer timer;
+};
+
+static QList<Version*> getVersions(GraphWidget* _graph)
+{
+    QList<Version*> versions;
+
+    foreach(QGraphicsItem * it, _graph->scene()->items())
+    {
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
+
+        Version* v = dynamic_cast<Version*>(it);
+
+        if (v && !v->getObjectId().isNull())
+            versions.push_back(v);
+    }
+
+    return versions;
+}
+
+static void usage()
+{
+    cerr << "gvtree_bench [-n runs] [-f gitlog] [-m pattern] [-r repository -c from to]" << endl;
+    cerr << endl;
+    cerr << "  -n  number of runs, default 3" << endl;
+    cerr << "  -f  git log --graph output, default " << BENCH_GITLOG << endl;
+    cerr << "  -m  search pattern of matchVersions, default \"Merge\"" << endl;
+    cerr << "  -r  repository for the compare phase" << endl;
+    cerr << "  -c  hashes compared in the repository" << endl;
+}
+
+int main(int argc, char** argv)
+{
+    // no display needed
+    if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QApplication app(argc, argv);
+
+    // own settings, the ones of gvtree are not touched
+    app.setOrganizationName("gvtree");
+    app.setOrganizationDomain("gvtree");
+    app.setApplicationName("gvtree_bench");
+
+    QSettings::setDefaultFormat(QSettings::IniFormat);
+
+    int runs = 3;
+    QString gitlog = BENCH_GITLOG;
+    QString pattern = "Merge";
+    QString repository;
+    QString from;
+    QString to;
+
+    QStringList args = QCoreApplication::arguments();
+
+    for (int i = 1; i < args.size(); i++)
+    {
+        if (args.at(i) == "-n" && i + 1 < args.size())
+            runs = args.at(++i).toInt();
+        else if (args.at(i) == "-f" && i + 1 < args.size())
+            gitlog = args.at(++i);
+        else if (args.at(i) == "-m" && i + 1 < args.size())
+            pattern = args.at(++i);
+        else if (args.at(i) == "-r" && i + 1 < args.size())
+            repository = args.at(++i);
+        else if (args.at(i) == "-c" && i + 2 < args.size())
+        {
+            from = args.at(++i);
+            to = args.at(++i);
+        }
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    QList<QString> lines;
+    QFile file(gitlog);
+
+    if (!file.open(QFile::ReadOnly | QFile::Text))
+    {
+        cerr << "Error: cannot open " << gitlog.toUtf8().data() << endl;
+        return 1;
+    }
+
+    while (!file.atEnd())
+    {
+        lines.push_back(QString::fromUtf8(file.readLine()));
+    }
+    file.close();
+
+    // commands would be printed to stdout
+    {
+        QSettings settings;
+        settings.setValue("printCmdToStdout", false);
+    }
+
+    // -t keeps the main window from loading a repository
+    MainWindow* mwin = new MainWindow(QStringList() << args.at(0) << "-t");
+    GraphWidget* graph = mwin->getGraphWidget();
+
+    for (int run = 0; run < runs; run++)
+    {
+        {
+            Phase phase("load", run);
+            graph->load(gitlog);
+        }
+
+        {
+            Phase phase("process", run);
+            graph->process(lines);
+        }
+
+        {
+            Phase phase("normalizeGraph", run);
+            graph->normalizeGraph();
+        }
+
+        {
+            QList<Version*> matches;
+            Phase phase("matchVersions", run);
+            graph->matchVersions(pattern, matches);
+        }
+
+        {
+            QList<Version*> versions = getVersions(graph);
+            TagTree* tagTree = mwin->getTagTree();
+
+            tagTree->blockSignals(true);
+            tagTree->resetTagTree();
+
+            Phase phase("addData", run);
+            foreach(const Version * v, versions)
+            {
+                tagTree->addData(v);
+            }
+            tagTree->compress();
+        }
+
+        if (repository.size() && from.size())
+        {
+            graph->setLocalRepositoryPath(repository);
+
+            Phase phase("compareHashes", run);
+            mwin->getCompareTree()->compareHashes(QStringList(from), to);
+        }
+    }
+
+    delete mwin;
+
+    return 0;
+}
@@ -0,0 +1,519 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * \brief Writes a synthetic history like
+ *        git log --graph --pretty="#%h#%at#%an#%d#%s#"
+ *        for gvtree -f and gvtree_bench -f.
+ *
+ *        The history is created newest first together with the graph:
+ *        each lane waits for a commit which is not written yet, so the
+ *        output is in topological order. The drawing uses the patterns
+ *        of git: '\' for merges and shifted lanes, '/' and '_' when a
+ *        lane joins another one and "*-." for octopus merges.
+ */
+class LogGenerator
+{
+public:
+    LogGenerator(FILE* _out, unsigned int _seed) :
+        commits(1000),
+        branches(0.05),
+        merges(0.1),
+        octopus(0.02),
+        lanes(8),
+        tags(0.01),
+        commentLength(40),
+        out(_out),
+        random(_seed),
+        created(0),
+        time(1600000000),
+        timeStep(3600),
+        lastWasTransition(false)
+    {
+    }
+
+    void generate();
+
+    int commits;
+    double branches;
+    double merges;
+    double octopus;
+    int lanes;
+    double tags;
+    int commentLength;
+
+private:
+    bool chance(double _p)
+    {
+        return uniform_real_distribution<double>(0, 1)(random) < _p;
+    }
+
+    int pick(int _n)
+    {
+        return uniform_int_distribution<int>(0, _n - 1)(random);
+    }
+
+    // unique abbreviated hash, the multiplier is odd, so the
+    // mapping of 28 bit numbers is a bijection
+    static string hash(int _id)
+    {
+        char buf[16];
+
+        snprintf(buf, sizeof(buf), "%07x", (unsigned int)(_id * 2654435761u) & 0xfffffff);
+        return buf;
+    }
+
+    // a commit which has not been written yet, -1 if all are created
+    int newCommit()
+    {
+        return (created < commits) ? created++ : -1;
+    }
+
+    // parents of the commit in _lane, the first one first
+    void chooseParents(int _lane, vector<int>& _parents);
+
+    // graph line plus version information
+    void writeLine(const string& _graph, const string& _info = string());
+
+    // "| | |" of all lanes, separates two transition lines,
+    // lanes right of _column are _shift lanes further right
+    void straightLine(int _column = -1, int _shift = 0);
+
+    // lanes right of _column are shifted by two characters
+    void shiftLine(int _column, int _shift);
+
+    // lane _column joins the lane _target on its left
+    void collapse(int _column, int _target);
+
+    string info(int _id);
+
+    FILE* out;
+    mt19937 random;
+
+    int created;
+    long long time;
+    int timeStep;
+
+    // commit each lane is waiting for
+    vector<int> lane;
+    bool lastWasTransition;
+};
+
+void LogGenerator::writeLine(const string& _graph, const string& _info)
+{
+    // no trailing blanks
+    size_t len = _graph.find_last_not_of(' ');
+
+    fwrite(_graph.data(), 1, len == string::npos ? 0 : len + 1, out);
+    if (_info.size())
+    {
+        fputc(' ', out);
+        fwrite(_info.data(), 1, _info.size(), out);
+    }
+    fputc('\n', out);
+
+    lastWasTransition = _info.empty();
+}
+
+void LogGenerator::straightLine(int _column, int _shift)
+{
+    string graph(2 * (lane.size() + _shift), ' ');
+
+    for (int k = 0; k < (int)lane.size(); k++)
+        graph[2 * (k > _column ? k + _shift : k)] = '|';
+
+    writeLine(graph);
+}
+
+void LogGenerator::shiftLine(int _column, int _shift)
+{
+    // a backslash right below a commit would be read as merge
+    if (lastWasTransition || _shift == 0)
+        straightLine(_column, _shift);
+
+    string graph(2 * (lane.size() + _shift + 1), ' ');
+
+    for (int k = 0; k < (int)lane.size(); k++)
+    {
+        if (k <= _column)
+            graph[2 * k] = '|';
+        else
+            graph[2 * (k + _shift) + 1] = '\\';
+    }
+
+    writeLine(graph);
+}
+
+void LogGenerator::collapse(int _column, int _target)
+{
+    if (lastWasTransition)
+        straightLine();
+
+    int m = lane.size();
+    string graph(2 * m, ' ');
+
+    for (int k = 0; k < _column; k++)
+        graph[2 * k] = '|';
+
+    // a lane crossing others moves horizontally first
+    for (int k = _target + 1; k < _column - 1; k++)
+        graph[2 * k + 1] = '_';
+
+    graph[2 * _column - 1] = '/';
+
+    // lanes on the right move one column to the left
+    for (int j = _column + 1; j < m; j++)
+        graph[2 * j - 1] = '/';
+
+    writeLine(graph);
+
+    if (_column > _target + 1)
+    {
+        string graph2(2 * m, ' ');
+
+        for (int k = 0; k < m - 1; k++)
+            graph2[2 * k] = '|';
+        graph2[2 * _target + 1] = '/';
+
+        writeLine(graph2);
+    }
+
+    lane.erase(lane.begin() + _column);
+}
+
+void LogGenerator::chooseParents(int _lane, vector<int>& _parents)
+{
+    int open = lane.size();
+
+    int count = 1;
+
+    if (chance(merges))
+        count = chance(octopus) ? 3 + pick(4) : 2;
+
+    for (int i = 0; i < count; i++)
+    {
+        int parent = -1;
+
+        // join another lane, always if the graph is too wide,
+        // more likely the more lanes are open
+        bool join = (open > 1) && (open >= lanes || chance(double(open) / lanes * (i == 0 ? 0.5 : 1.0)));
+
+        if (join)
+        {
+            int other = pick(open - 1);
+
+            parent = lane[other < _lane ? other : other + 1];
+        }
+        else
+            parent = newCommit();
+
+        if (parent == -1)
+        {
+            // budget exhausted, the lane ends unless it can join
+            if (open > 1)
+            {
+                int other = pick(open - 1);
+                parent = lane[other < _lane ? other : other + 1];
+            }
+            else
+                break;
+        }
+
+        bool known = false;
+
+        for (size_t p = 0; p < _parents.size(); p++)
+            known = known || (_parents[p] == parent);
+
+        if (!known)
+            _parents.push_back(parent);
+    }
+}
+
+string LogGenerator::info(int _id)
+{
+    static const char* authors[] =
+    {
+        "Alice Adams", "Bob Brown", "Carol Clark", "Dave Davis",
+        "Eve Evans", "Frank Fischer", "Grace Green", "Heidi Hill"
+    };
+    static const char* words[] =
+    {
+        "fix", "add", "remove", "update", "refactor", "parser", "layout",
+        "graph", "version", "branch", "merge", "tag", "cache", "test",
+        "widget", "preferences", "compare", "tree", "search", "docs"
+    };
+
+    string decoration;
+
+    if (_id == 0)
+        decoration = " (HEAD -> master)";
+    else if (chance(tags))
+        decoration = " (tag: v" + to_string(_id % 10) + "." + to_string(_id % 97) + "." + to_string(_id) + ")";
+
+    string comment;
+
+    while ((int)comment.size() < commentLength)
+    {
+        if (comment.size())
+            comment += ' ';
+        comment += words[pick(sizeof(words) / sizeof(words[0]))];
+    }
+    comment.resize(commentLength);
+
+    // older commits have older author dates
+    time -= 1 + pick(timeStep);
+
+    return "#" + hash(_id) + "#" + to_string(time) + "#"
+        + authors[pick(sizeof(authors) / sizeof(authors[0]))] + "#"
+        + decoration + "#" + comment + "#";
+}
+
+void LogGenerator::generate()
+{
+    int written = 0;
+
+    // at most an hour between two commits, but after 1970
+    timeStep = min(3600LL, time / 2 / commits);
+
+    while (written < commits)
+    {
+        int column = -1;
+
+        // a new branch tip appears on the right
+        if (lane.empty() || ((int)lane.size() < lanes && chance(branches)))
+        {
+            int id = newCommit();
+
+            if (id != -1)
+            {
+                lane.push_back(id);
+                column = lane.size() - 1;
+            }
+        }
+
+        if (lane.empty())
+            break;
+
+        if (column == -1)
+            column = pick(lane.size());
+
+        int id = lane[column];
+
+        vector<int> parents;
+        chooseParents(column, parents);
+
+        int n = parents.size();
+
+        // octopus merges need room on the right
+        for (int s = 0; s < n - 2 && column + 1 < (int)lane.size(); s++)
+            shiftLine(column, s);
+
+        // commit line
+        int shift = (n > 2) ? n - 2 : 0;
+        string graph(2 * (lane.size() + shift), ' ');
+
+        for (int k = 0; k < (int)lane.size(); k++)
+        {
+            if (k < column)
+                graph[2 * k] = '|';
+            else if (k > column)
+                graph[2 * (k + shift)] = '|';
+        }
+
+        graph[2 * column] = '*';
+        for (int d = 1; d < 2 * shift; d++)
+            graph[2 * column + d] = '-';
+        if (shift)
+            graph[2 * column + 2 * shift] = '.';
+
+        writeLine(graph, info(id));
+        written++;
+
+        int m = lane.size();
+
+        if (n == 0)
+        {
+            // root, lanes on the right move to the left
+            if (column + 1 < m)
+            {
+                string removed(2 * m, ' ');
+
+                for (int k = 0; k < m; k++)
+                {
+                    if (k < column)
+                        removed[2 * k] = '|';
+                    else if (k > column)
+                        removed[2 * k - 1] = '/';
+                }
+                writeLine(removed);
+            }
+            lane.erase(lane.begin() + column);
+            continue;
+        }
+
+        if (n > 1)
+        {
+            // the merged parents get lanes next to the merge
+            string merge(2 * (m + n), ' ');
+
+            for (int k = 0; k < m; k++)
+            {
+                if (k <= column)
+                    merge[2 * k] = '|';
+                else
+                    merge[2 * (k + n - 1) - 1] = '\\';
+            }
+            for (int p = 1; p < n; p++)
+                merge[2 * (column + p) - 1] = '\\';
+
+            writeLine(merge);
+        }
+
+        lane[column] = parents[0];
+        lane.insert(lane.begin() + column + 1, parents.begin() + 1, parents.end());
+
+        // lanes waiting for the same commit join the leftmost one
+        for (;;)
+        {
+            int from = -1;
+            int to = -1;
+
+            for (int i = lane.size() - 1; i > 0 && from == -1; i--)
+            {
+                for (int t = 0; t < i; t++)
+                {
+                    if (lane[t] == lane[i])
+                    {
+                        from = i;
+                        to = t;
+                        break;
+                    }
+                }
+            }
+
+            if (from == -1)
+                break;
+
+            collapse(from, to);
+        }
+    }
+}
+
+static void usage()
+{
+    fprintf(stderr,
+            "gvtree_loggen [options] [file]\n"
+            "\n"
+            "Writes a synthetic git log --graph --pretty=\"#%%h#%%at#%%an#%%d#%%s#\"\n"
+            "to file or stdout, to be loaded with gvtree -f or gvtree_bench -f.\n"
+            "\n"
+            "  -n commits        number of commits, default 1000\n"
+            "  -b probability    a new branch tip starts, default 0.05\n"
+            "  -m probability    a commit is a merge, default 0.1\n"
+            "  -o probability    a merge is an octopus merge, default 0.02\n"
+            "  -w lanes          maximum number of open lanes, default 8\n"
+            "  -t probability    a commit is tagged, default 0.01\n"
+            "  -c length         comment length, default 40\n"
+            "  -s seed           random seed, default 1\n");
+}
+
+int main(int argc, char** argv)
+{
+    unsigned int seed = 1;
+    const char* path = NULL;
+
+    LogGenerator defaults(NULL, 0);
+    int commits = defaults.commits;
+    double branches = defaults.branches;
+    double merges = defaults.merges;
+    double octopus = defaults.octopus;
+    int lanes = defaults.lanes;
+    double tags = defaults.tags;
+    int commentLength = defaults.commentLength;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool value = i + 1 < argc;
+
+        if (!strcmp(argv[i], "-n") && value)
+            commits = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && value)
+            branches = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-m") && value)
+            merges = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-o") && value)
+            octopus = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-w") && value)
+            lanes = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-t") && value)
+            tags = atof(argv[++i]);
+        else if (!strcmp(argv[i], "-c") && value)
+            commentLength = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-s") && value)
+            seed = strtoul(argv[++i], NULL, 10);
+        else if (argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // the abbreviated hashes have 28 bits
+    if (commits < 1 || commits > (1 << 28) || lanes < 1 || commentLength < 1)
+    {
+        usage();
+        return 1;
+    }
+
+    FILE* out = path ? fopen(path, "w") : stdout;
+
+    if (out == NULL)
+    {
+        fprintf(stderr, "Error: cannot open %s\n", path);
+        return 1;
+    }
+
+    LogGenerator generator(out, seed);
+
+    generator.commits = commits;
+    generator.branches = branches;
+    generator.merges = merges;
+    generator.octopus = octopus;
+    generator.lanes = lanes;
+    generator.tags = tags;
+    generator.commentLength = commentLength;
+
+    generator.generate();
+
+    if (path)
+        fclose(out);
+
+    return 0;
+}
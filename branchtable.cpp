@@ -16,14 +16,17 @@
 /* --------------------------------------------- */
 
 #include <QSettings>
+#include <QDateTime>
 #include "execute_cmd.h"
 #include "branchtable.h"
 #include "mainwindow.h"
+#include "graphwidget.h"
+#include "refdatabase.h"
 
 #include <iostream>
 
 BranchTable::BranchTable(QWidget* _parent) : QTableWidget(_parent),
-    mwin(NULL), currentBranch(NULL), selectedBranch(NULL), blockReload(false)
+    mwin(NULL), currentBranch(NULL), selectedBranch(NULL), blockReload(false), focusPending(false)
 {
     verticalHeader()->hide();
 
@@ -49,6 +52,120 @@ BranchTable::BranchTable(QWidget* _parent) : QTableWidget(_parent),
 void BranchTable::setMainWindow(MainWindow* _mwin)
 {
     mwin = _mwin;
+
+    if (mwin)
+        connect(mwin->getGraphWidget(), SIGNAL(loadFinished()), this, SLOT(loadFinished()));
+}
+
+// "%(committerdate:iso8601)" of a raw commit object
+static QString committerDate(const QByteArray& _commit)
+{
+    int start = _commit.indexOf("\ncommitter ");
+    int end = (start == -1) ? -1 : _commit.indexOf('\n', start + 1);
+
+    if (end == -1)
+        return QString();
+
+    QByteArray line = _commit.mid(start + 1, end - start - 1);
+    int zonePos = line.lastIndexOf(' ');
+    int timePos = zonePos > 0 ? line.lastIndexOf(' ', zonePos - 1) : -1;
+
+    if (timePos < 0)
+        return QString();
+
+    QByteArray zone = line.mid(zonePos + 1);
+    int offset = zone.mid(1, 2).toInt() * 3600 + zone.mid(3, 2).toInt() * 60;
+
+    if (zone.startsWith('-'))
+        offset = -offset;
+
+    QDateTime date = QDateTime::fromMSecsSinceEpoch(
+        (line.mid(timePos + 1, zonePos - timePos - 1).toLongLong() + offset) * 1000,
+        Qt::UTC);
+
+    return date.toString("yyyy-MM-dd HH:mm:ss") + " " + QString::fromLatin1(zone);
+}
+
+bool BranchTable::readBranches(const QString& _localRepositoryPath, QMap<QString, QString>& _dates, QString& _current)
+{
+    RefDatabase refDatabase;
+
+    if (!refDatabase.read(_localRepositoryPath, QStringList() << "refs/heads/" << "refs/remotes/"))
+        return false;
+
+    // commit dates of new ref targets, commits do not change
+    QStringList missing;
+
+    foreach(const QString& oid, refDatabase.getRefs())
+    {
+        if (!commitDates.contains(oid))
+            missing.push_back(oid);
+    }
+
+    if (refDatabase.getHead().startsWith("refs/") == false && !commitDates.contains(refDatabase.getHead()))
+        missing.push_back(refDatabase.getHead());
+
+    if (missing.size())
+    {
+        mwin->getGraphWidget()->getCatFile()->read(
+            missing,
+            [this, &missing](int _index, const QByteArray& _type, const QByteArray& _content)
+            {
+                if (_type == "commit")
+                    commitDates.insert(missing.at(_index), committerDate(_content));
+            });
+    }
+
+    for (QMap<QString, QString>::const_iterator it = refDatabase.getRefs().constBegin();
+         it != refDatabase.getRefs().constEnd();
+         ++it)
+    {
+        // refname:short
+        QString name = it.key().mid(it.key().startsWith("refs/heads/") ? 11 : 13);
+
+        if (it.key() == refDatabase.getHead())
+            _current = name;
+
+        if (commitDates.contains(it.value()))
+            _dates.insert(name, commitDates.value(it.value()));
+    }
+
+    // detached HEAD as shown by git branch
+    if (refDatabase.getHead().startsWith("refs/") == false)
+    {
+        _current = "(HEAD detached at " + refDatabase.getHead().left(7) + ")";
+        _dates.insert(_current, commitDates.value(refDatabase.getHead()));
+    }
+
+    return true;
+}
+
+void BranchTable::runGitBranch(const QString& _localRepositoryPath, QMap<QString, QString>& _dates, QString& _current)
+{
+    QStringList cmd = QStringList()
+        << "git" << "-C" << _localRepositoryPath
+        << "branch" << "-l"
+        << "--format=%(HEAD);%(refname:short);%(committerdate:iso8601);"
+        << "--all" << "--sort=committerdate";
+    QList<QString> cache;
+
+    execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
+
+    foreach(const QString& it, cache)
+    {
+        if (it.indexOf("->") > 0)
+            continue;
+
+        QStringList line = it.split(';');
+
+        if (line.size() < 3)
+            continue;
+
+        if (line.at(0).startsWith('*'))
+            _current = line.at(1);
+
+        _dates.insert(line.at(1), line.at(2));
+    }
 }
 
 void BranchTable::refresh(const QString& _localRepositoryPath)
@@ -58,7 +175,17 @@ void BranchTable::refresh(const QString& _localRepositoryPath)
 
     bool sigstat = blockSignals(true);
 
-    clear();
+    // rows of another repository
+    if (repositoryPath != _localRepositoryPath)
+    {
+        clear();
+        setRowCount(0);
+        rows.clear();
+        commitDates.clear();
+        currentBranch = NULL;
+        selectedBranch = NULL;
+        repositoryPath = _localRepositoryPath;
+    }
 
     // Create header elements
     QStringList header;
@@ -68,51 +195,69 @@ void BranchTable::refresh(const QString& _localRepositoryPath)
     setHorizontalHeaderLabels(header);
     setSortingEnabled(false);
 
-    // get branch data
-    QString cmd = "git -C " + _localRepositoryPath + " branch -l --format=\"%(HEAD);%(refname:short);%(committerdate:iso8601);\" --all --sort=committerdate";
-    QList<QString> cache;
+    // get branch data, git branch is only used if the
+    // ref files can not be read
+    QMap<QString, QString> dates;
+    QString current;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
+    if (!readBranches(_localRepositoryPath, dates, current))
+        runGitBranch(_localRepositoryPath, dates, current);
 
-    // insert data
-    foreach(const QString& it, cache)
+    // remove the rows of deleted branches
+    foreach(const QString& name, rows.keys())
     {
-        if (it.indexOf("->") > 0)
+        if (dates.contains(name))
             continue;
 
-        QStringList line = it.split(';');
+        QTableWidgetItem* item = rows.take(name);
 
-        QString col = line.front();
-        bool current = (col.at(0) == '*');
+        if (item == currentBranch)
+            currentBranch = NULL;
+        if (item == selectedBranch)
+            selectedBranch = NULL;
 
-        line.pop_front();
-        if (line.isEmpty())
-            continue;
+        removeRow(item->row());
+    }
+
+    // update changed and insert new rows
+    for (QMap<QString, QString>::const_iterator it = dates.constBegin(); it != dates.constEnd(); ++it)
+    {
+        QTableWidgetItem* item = rows.value(it.key(), NULL);
 
-        QString branchName = line.front();
+        if (item)
+        {
+            QTableWidgetItem* dateItem = this->item(item->row(), 1);
 
-        line.pop_front();
-        if (line.isEmpty())
-            continue;
+            if (dateItem->text() != it.value())
+                dateItem->setText(it.value());
+        }
+        else
+        {
+            insertRow(rowCount());
+            item = new QTableWidgetItem(it.key());
+            item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            setItem(rowCount() - 1, 0, item);
 
-        QString branchDate = line.front();
+            QTableWidgetItem* dateItem = new QTableWidgetItem(it.value());
+            dateItem->setFlags(Qt::NoItemFlags);
+            setItem(rowCount() - 1, 1, dateItem);
 
-        insertRow(rowCount());
-        QTableWidgetItem* item = new QTableWidgetItem(branchName);
+            rows.insert(it.key(), item);
+        }
+
+        bool isCurrent = (it.key() == current);
 
-        if (current)
+        if (isCurrent != item->font().bold())
         {
             QFont font = item->font();
-            font.setBold(true);
+            font.setBold(isCurrent);
             item->setFont(font);
-            currentBranch = item;
         }
 
-        item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
-        setItem(rowCount() - 1, 0, item);
-        item = new QTableWidgetItem(branchDate);
-        item->setFlags(Qt::NoItemFlags);
-        setItem(rowCount() - 1, 1, item);
+        if (isCurrent)
+            currentBranch = item;
+        else if (item == currentBranch)
+            currentBranch = NULL;
     }
     setSortingEnabled(true);
 
@@ -126,7 +271,7 @@ void BranchTable::refresh(const QString& _localRepositoryPath)
     sortByColumn(settings.value("BranchTable/sortColumn").toInt(),
                  settings.value("BranchTable/sortOrder").toInt() == 0 ? Qt::AscendingOrder : Qt::DescendingOrder);
 
-    connect(horizontalHeader(), SIGNAL(sectionClicked(int)), this, SLOT(sortChanged(int)));
+    connect(horizontalHeader(), SIGNAL(sectionClicked(int)), this, SLOT(sortChanged(int)), Qt::UniqueConnection);
 
     blockSignals(sigstat);
 }
@@ -141,7 +286,8 @@ void BranchTable::sortChanged(int _col)
 
 void BranchTable::lookupCurrent()
 {
-    lookupBranch(currentBranch->row(), 0);
+    if (currentBranch)
+        lookupBranch(currentBranch->row(), 0);
 }
 
 void BranchTable::lookupBranch(int _row, int /*_col*/)
@@ -161,12 +307,27 @@ void BranchTable::branchSelectionChanged()
         blockReload = true;
         mwin->reloadCurrentRepository();
         blockReload = false;
+
+        // versions of the branch are available after the load
+        focusPending = true;
+        return;
     }
 
     if (!mwin->getGraphWidget()->focusElements(getSelectedBranch(), true, QString("Branch")))
         mwin->getGraphWidget()->focusElements(getSelectedBranch(), false, QString("Branch"));
 }
 
+void BranchTable::loadFinished()
+{
+    if (focusPending == false)
+        return;
+
+    focusPending = false;
+
+    if (!mwin->getGraphWidget()->focusElements(getSelectedBranch(), true, QString("Branch")))
+        mwin->getGraphWidget()->focusElements(getSelectedBranch(), false, QString("Branch"));
+}
+
 void BranchTable::onCustomContextMenu(const QPoint& point)
 {
     QMenu* menu = new QMenu(this);
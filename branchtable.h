@@ -24,6 +24,8 @@
 #include <QTableWidget>
 #include <QWidget>
 #include <QString>
+#include <QMap>
+#include <QHash>
 
 class BranchTable : public QTableWidget
 {
@@ -44,16 +46,30 @@ public slots:
     void lookupCurrent();
     void lookupBranch(int _row, int _column);
     void onCustomContextMenu(const QPoint& point);
+    void loadFinished();
 
 protected:
     // block right button to allow context menu
     virtual void mousePressEvent (QMouseEvent* event);
     void branchSelectionChanged();
 
+    // branch name to committer date and the current branch from the ref files
+    bool readBranches(const QString& _localRepositoryPath, QMap<QString, QString>& _dates, QString& _current);
+    // same from git branch
+    void runGitBranch(const QString& _localRepositoryPath, QMap<QString, QString>& _dates, QString& _current);
+
     class MainWindow* mwin;
     QTableWidgetItem* currentBranch;
     QTableWidgetItem* selectedBranch;
     bool blockReload;
+    // focus the selected branch when the reload has finished
+    bool focusPending;
+
+    // rows of the branches of repositoryPath
+    QString repositoryPath;
+    QMap<QString, QTableWidgetItem*> rows;
+    // commit id to committer date
+    QHash<QString, QString> commitDates;
 };
 
 #endif
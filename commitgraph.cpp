@@ -0,0 +1,366 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <string.h>
+#include <iostream>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include "commitgraph.h"
+#include "refdatabase.h"
+
+using namespace std;
+
+// chunk ids, see git Documentation/gitformat-commit-graph.txt
+static const quint32 chunkOidFanout = 0x4f494446; // "OIDF"
+static const quint32 chunkOidLookup = 0x4f49444c; // "OIDL"
+static const quint32 chunkCommitData = 0x43444154; // "CDAT"
+static const quint32 chunkExtraEdges = 0x45444745; // "EDGE"
+
+static const quint32 parentNone = 0x70000000;
+static const quint32 parentExtraEdges = 0x80000000;
+static const quint32 parentLast = 0x80000000;
+
+static quint32 readUInt32(const uchar* _data)
+{
+    return qFromBigEndian<quint32>(_data);
+}
+
+CommitGraph::CommitGraph() :
+    hashLength(0),
+    commits(0)
+{
+}
+
+CommitGraph::~CommitGraph()
+{
+    close();
+}
+
+QString CommitGraph::objectsPath(const QString& _repositoryPath)
+{
+    QString worktreeDir;
+    QString gitDir;
+
+    if (!RefDatabase::gitDirectories(_repositoryPath, worktreeDir, gitDir))
+        return QString();
+
+    // git itself ignores the commit-graph for shallow clones and grafts
+    if (QFileInfo(gitDir + "/shallow").exists()
+        || QFileInfo(gitDir + "/info/grafts").exists())
+        return QString();
+
+    return gitDir + "/objects";
+}
+
+bool CommitGraph::open(const QString& _repositoryPath)
+{
+    close();
+
+    QString objects = objectsPath(_repositoryPath);
+
+    if (objects.isEmpty())
+        return false;
+
+    QString single = objects + "/info/commit-graph";
+
+    if (QFileInfo(single).exists())
+    {
+        if (openLayer(single))
+            return true;
+
+        close();
+        return false;
+    }
+
+    // split commit-graph: the chain lists the base graph first
+    QFile chain(objects + "/info/commit-graphs/commit-graph-chain");
+
+    if (!chain.open(QIODevice::ReadOnly))
+        return false;
+
+    while (!chain.atEnd())
+    {
+        QString hash = QString::fromLatin1(chain.readLine()).trimmed();
+
+        if (hash.isEmpty())
+            continue;
+
+        if (!openLayer(objects + "/info/commit-graphs/graph-" + hash + ".graph"))
+        {
+            close();
+            return false;
+        }
+    }
+
+    return isOpen();
+}
+
+void CommitGraph::close()
+{
+    foreach (const Layer& layer, layers)
+    {
+        delete (layer.file);
+    }
+    layers.clear();
+    hashLength = 0;
+    commits = 0;
+}
+
+bool CommitGraph::isOpen() const
+{
+    return layers.isEmpty() == false;
+}
+
+int CommitGraph::size() const
+{
+    return commits;
+}
+
+bool CommitGraph::openLayer(const QString& _path)
+{
+    QFile* file = new QFile(_path);
+
+    if (!file->open(QIODevice::ReadOnly))
+    {
+        delete (file);
+        return false;
+    }
+
+    qint64 size = file->size();
+    const uchar* data = file->map(0, size);
+
+    // header: signature, version, hash version, chunks, base graphs
+    if (!data || size < 8 || memcmp(data, "CGPH", 4) != 0 || data[4] != 1)
+    {
+        cerr << "Error: Invalid commit-graph " << _path.toUtf8().data() << endl;
+        delete (file);
+        return false;
+    }
+
+    int length = (data[5] == 1) ? 20 : ((data[5] == 2) ? 32 : 0);
+    int chunks = data[6];
+
+    if (length == 0
+        || (hashLength != 0 && length != hashLength)
+        || size < 8 + 12 * (chunks + 1))
+    {
+        delete (file);
+        return false;
+    }
+
+    Layer layer;
+
+    layer.file = file;
+    layer.fanout = NULL;
+    layer.oids = NULL;
+    layer.commitData = NULL;
+    layer.extraEdges = NULL;
+    layer.extraEdgesSize = 0;
+    layer.count = 0;
+    layer.offset = commits;
+
+    quint64 oidsSize = 0;
+    quint64 commitDataSize = 0;
+
+    // table of contents, the last entry terminates the last chunk
+    for (int i = 0; i < chunks; i++)
+    {
+        const uchar* toc = data + 8 + 12 * i;
+        quint32 id = readUInt32(toc);
+        quint64 begin = qFromBigEndian<quint64>(toc + 4);
+        quint64 end = qFromBigEndian<quint64>(toc + 16);
+
+        if (end < begin || end > quint64(size))
+        {
+            delete (file);
+            return false;
+        }
+
+        if (id == chunkOidFanout && end - begin >= 256 * 4)
+            layer.fanout = data + begin;
+        else if (id == chunkOidLookup)
+        {
+            layer.oids = data + begin;
+            oidsSize = end - begin;
+        }
+        else if (id == chunkCommitData)
+        {
+            layer.commitData = data + begin;
+            commitDataSize = end - begin;
+        }
+        else if (id == chunkExtraEdges)
+        {
+            layer.extraEdges = data + begin;
+            layer.extraEdgesSize = (end - begin) / 4;
+        }
+    }
+
+    if (layer.fanout)
+        layer.count = readUInt32(layer.fanout + 255 * 4);
+
+    if (!layer.fanout || !layer.oids || !layer.commitData
+        || oidsSize < quint64(layer.count) * length
+        || commitDataSize < quint64(layer.count) * (length + 16))
+    {
+        cerr << "Error: Incomplete commit-graph " << _path.toUtf8().data() << endl;
+        delete (file);
+        return false;
+    }
+
+    hashLength = length;
+    commits += layer.count;
+    layers.push_back(layer);
+
+    return true;
+}
+
+const CommitGraph::Layer* CommitGraph::findLayer(int _pos) const
+{
+    if (_pos < 0)
+        return NULL;
+
+    for (int l = 0; l < layers.size(); l++)
+    {
+        const Layer& layer = layers.at(l);
+
+        if (quint32(_pos) >= layer.offset && quint32(_pos) < layer.offset + layer.count)
+            return &layer;
+    }
+
+    return NULL;
+}
+
+int CommitGraph::lookup(const QString& _hash) const
+{
+    QByteArray oid = QByteArray::fromHex(_hash.toLatin1());
+
+    if (oid.size() != hashLength)
+        return -1;
+
+    return lookup(oid);
+}
+
+int CommitGraph::lookup(const char* _hash, int _size) const
+{
+    QByteArray oid = QByteArray::fromHex(QByteArray::fromRawData(_hash, _size));
+
+    if (oid.size() != hashLength)
+        return -1;
+
+    return lookup(oid);
+}
+
+int CommitGraph::lookup(const QByteArray& _oid) const
+{
+    const uchar* oid = reinterpret_cast<const uchar*>(_oid.constData());
+
+    // the newest layer is the smallest one
+    for (int l = layers.size() - 1; l >= 0; l--)
+    {
+        const Layer& layer = layers.at(l);
+
+        // the fanout table narrows the range by the first byte
+        quint32 lo = oid[0] ? readUInt32(layer.fanout + (oid[0] - 1) * 4) : 0;
+        quint32 hi = readUInt32(layer.fanout + oid[0] * 4);
+
+        while (lo < hi)
+        {
+            quint32 mid = lo + (hi - lo) / 2;
+            int cmp = memcmp(layer.oids + quint64(mid) * hashLength, oid, hashLength);
+
+            if (cmp == 0)
+                return layer.offset + mid;
+
+            if (cmp < 0)
+                lo = mid + 1;
+            else
+                hi = mid;
+        }
+    }
+
+    return -1;
+}
+
+QString CommitGraph::getHash(int _pos) const
+{
+    const Layer* layer = findLayer(_pos);
+
+    if (!layer)
+        return QString();
+
+    const char* oid = reinterpret_cast<const char*>(layer->oids + quint64(_pos - layer->offset) * hashLength);
+
+    return QString::fromLatin1(QByteArray(oid, hashLength).toHex());
+}
+
+void CommitGraph::getParents(int _pos, QVector<int>& _parents) const
+{
+    _parents.clear();
+
+    const Layer* layer = findLayer(_pos);
+
+    if (!layer)
+        return;
+
+    // tree oid, first parent, second parent, generation and date
+    const uchar* entry = layer->commitData + quint64(_pos - layer->offset) * (hashLength + 16);
+    quint32 parent1 = readUInt32(entry + hashLength);
+    quint32 parent2 = readUInt32(entry + hashLength + 4);
+
+    if (parent1 == parentNone)
+        return;
+
+    _parents.push_back(parent1);
+
+    if (parent2 == parentNone)
+        return;
+
+    if ((parent2 & parentExtraEdges) == 0)
+    {
+        _parents.push_back(parent2);
+        return;
+    }
+
+    // octopus merge: the second and all further parents are listed
+    // in the extra edge chunk, the last one is marked
+    for (quint32 i = parent2 & ~parentExtraEdges; i < layer->extraEdgesSize; i++)
+    {
+        quint32 edge = readUInt32(layer->extraEdges + i * 4);
+
+        _parents.push_back(edge & ~parentLast);
+
+        if (edge & parentLast)
+            break;
+    }
+}
+
+qint64 CommitGraph::getCommitTime(int _pos) const
+{
+    const Layer* layer = findLayer(_pos);
+
+    if (!layer)
+        return 0;
+
+    const uchar* entry = layer->commitData + quint64(_pos - layer->offset) * (hashLength + 16);
+
+    // the upper 30 bits contain the generation number
+    return (qint64(readUInt32(entry + hashLength + 8) & 0x3) << 32)
+           | readUInt32(entry + hashLength + 12);
+}
@@ -0,0 +1,92 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __COMMITGRAPH_H__
+#define __COMMITGRAPH_H__
+
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+/**
+ * \brief Read only access to the commit-graph file git keeps in
+ *        objects/info/commit-graph or as a chain of split graphs in
+ *        objects/info/commit-graphs. The files are memory mapped,
+ *        commits are addressed by their position in the graph.
+ *        Positions are counted over all layers of a chain, the
+ *        base graph first, as done by git itself.
+ */
+class CommitGraph
+{
+public:
+    CommitGraph();
+    ~CommitGraph();
+
+    /**
+     * \brief Map the commit-graph of the repository in _repositoryPath.
+     *
+     * \return false, if there is no usable commit-graph
+     */
+    bool open(const QString& _repositoryPath);
+    void close();
+
+    bool isOpen() const;
+
+    // number of commits in all layers
+    int size() const;
+
+    // position of the commit _hash (full hex hash) or -1
+    int lookup(const QString& _hash) const;
+
+    // position of the commit given as _size hex digits or -1
+    int lookup(const char* _hash, int _size) const;
+
+    QString getHash(int _pos) const;
+
+    // parent positions of the commit at _pos, the first parent first
+    void getParents(int _pos, QVector<int>& _parents) const;
+
+    // committer time in seconds since epoch
+    qint64 getCommitTime(int _pos) const;
+
+private:
+    struct Layer
+    {
+        QFile* file;
+        const uchar* fanout;
+        const uchar* oids;
+        const uchar* commitData;
+        const uchar* extraEdges;
+        quint32 extraEdgesSize;
+        quint32 count;
+        quint32 offset;
+    };
+
+    // path of the objects directory, worktrees use the common dir
+    static QString objectsPath(const QString& _repositoryPath);
+
+    bool openLayer(const QString& _path);
+    const Layer* findLayer(int _pos) const;
+    int lookup(const QByteArray& _oid) const;
+
+    QList<Layer> layers;
+    int hashLength;
+    int commits;
+};
+
+#endif
@@ -0,0 +1,131 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <QDateTime>
+#include <QList>
+#include <QLocale>
+
+#include "commitinfo.h"
+#include "gitcatfile.h"
+
+// "Name <email> <time> <zone>" of an author line as shown by git log
+static QString formatAuthor(const QByteArray& _line, QString& _date)
+{
+    int zonePos = _line.lastIndexOf(' ');
+    int timePos = zonePos > 0 ? _line.lastIndexOf(' ', zonePos - 1) : -1;
+
+    if (timePos < 0)
+    {
+        _date = QString();
+        return QString::fromUtf8(_line);
+    }
+
+    QByteArray zone = _line.mid(zonePos + 1);
+    int offset = zone.mid(1, 2).toInt() * 3600 + zone.mid(3, 2).toInt() * 60;
+
+    if (zone.startsWith('-'))
+        offset = -offset;
+
+    // local time of the author
+    QDateTime date = QDateTime::fromMSecsSinceEpoch(
+        (_line.mid(timePos + 1, zonePos - timePos - 1).toLongLong() + offset) * 1000,
+        Qt::UTC);
+
+    _date = QLocale::c().toString(date, "ddd MMM d HH:mm:ss yyyy") + " " + QString::fromLatin1(zone);
+
+    return QString::fromUtf8(_line.left(timePos));
+}
+
+QString formatCommitInfo(const QString& _hash, const QByteArray& _oid, const QByteArray& _commit)
+{
+    int bodyPos = _commit.indexOf("\n\n");
+    QList<QByteArray> header = _commit.left(bodyPos < 0 ? _commit.size() : bodyPos).split('\n');
+    QStringList parents;
+    QString author;
+    QString date;
+
+    // abbreviate the parents like the version hashes
+    int abbrev = _hash.size() < _oid.size() ? _hash.size() : 7;
+
+    foreach(const QByteArray& line, header)
+    {
+        // continuation lines of multi line headers like gpgsig start with a blank
+        if (line.startsWith("parent "))
+            parents.push_back(QString::fromLatin1(line.mid(7, abbrev)));
+        else if (line.startsWith("author "))
+            author = formatAuthor(line.mid(7), date);
+    }
+
+    QString text = "commit " + QString::fromLatin1(_oid) + "\n";
+
+    if (parents.size() > 1)
+        text += "Merge: " + parents.join(QChar(' ')) + "\n";
+
+    text += "Author: " + author + "\n";
+    text += "Date:   " + date + "\n";
+
+    if (bodyPos >= 0)
+    {
+        QList<QByteArray> body = _commit.mid(bodyPos + 2).split('\n');
+
+        // leading blank lines and the trailing newline are dropped
+        while (!body.isEmpty() && body.first().trimmed().isEmpty())
+            body.removeFirst();
+        while (!body.isEmpty() && body.last().trimmed().isEmpty())
+            body.removeLast();
+
+        text += "\n";
+        foreach(const QByteArray& line, body)
+        {
+            text += "    " + QString::fromUtf8(line) + "\n";
+        }
+    }
+
+    return text;
+}
+
+CommitInfoPrefetcher::CommitInfoPrefetcher(GitCatFile* _catFile,
+                                           const QString& _repositoryPath,
+                                           const QStringList& _hashes,
+                                           QObject* _parent) :
+    QThread(_parent),
+    catFile(_catFile),
+    repositoryPath(_repositoryPath),
+    hashes(_hashes)
+{
+}
+
+void CommitInfoPrefetcher::run()
+{
+    catFile->readObjects(
+        hashes,
+        [this](int _index, const QByteArray& _oid, const QByteArray& _type, const QByteArray& _content)
+        {
+            if (_type == "commit")
+                infos.insert(hashes.at(_index), formatCommitInfo(hashes.at(_index), _oid, _content));
+        });
+}
+
+const QString& CommitInfoPrefetcher::getRepositoryPath() const
+{
+    return repositoryPath;
+}
+
+const QMap<QString, QString>& CommitInfoPrefetcher::getInfos() const
+{
+    return infos;
+}
@@ -0,0 +1,63 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __COMMITINFO_H__
+#define __COMMITINFO_H__
+
+#include <QByteArray>
+#include <QMap>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+class GitCatFile;
+
+/**
+ * \brief Format the raw commit object _commit with the object id _oid
+ *        like git log -1. Merge parents are abbreviated like the
+ *        version hash _hash.
+ */
+QString formatCommitInfo(const QString& _hash, const QByteArray& _oid, const QByteArray& _commit);
+
+/**
+ * \brief Reads and formats the commit info of several versions in a
+ *        background thread, e.g. the neighbours of the selected one.
+ */
+class CommitInfoPrefetcher : public QThread
+{
+public:
+    CommitInfoPrefetcher(GitCatFile* _catFile,
+                         const QString& _repositoryPath,
+                         const QStringList& _hashes,
+                         QObject* _parent = NULL);
+
+    const QString& getRepositoryPath() const;
+
+    // version hash to commit info
+    const QMap<QString, QString>& getInfos() const;
+
+protected:
+    virtual void run();
+
+private:
+    GitCatFile* catFile;
+    QString repositoryPath;
+    QStringList hashes;
+    QMap<QString, QString> infos;
+};
+
+#endif
@@ -0,0 +1,659 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <algorithm>
+
+#include <QDateTime>
+
+#include "commitstore.h"
+
+const QString CommitStore::inputKey("_input");
+const QString CommitStore::hashKey("Hash");
+const QString CommitStore::dateKey("Commit Date");
+const QString CommitStore::authorKey("User Name");
+const QString CommitStore::commentKey("Comment");
+const QString CommitStore::commentRawKey("CommentRaw");
+
+static const ObjectId nullId;
+static const QString emptyString;
+
+// about 2 MB of wrapped comments, more than visible at once
+static const int wrapCacheCost = 1024 * 1024;
+
+CommitStore::WrapCache::WrapCache() :
+    columns(0),
+    maxlen(0),
+    lines(wrapCacheCost)
+{
+}
+
+CommitStore::WrapCache::WrapCache(const WrapCache& _other) :
+    columns(_other.columns),
+    maxlen(_other.maxlen),
+    lines(wrapCacheCost)
+{
+}
+
+CommitStore::WrapCache& CommitStore::WrapCache::operator=(const WrapCache& _other)
+{
+    columns = _other.columns;
+    maxlen = _other.maxlen;
+    lines.clear();
+
+    return *this;
+}
+
+// comments replaced by setInput() are dropped from the buffer, once
+// they take more than half of it and at least this many characters
+static const int deadCommentMin = 64 * 1024;
+
+CommitStore::CommitStore() : deadComment(0)
+{
+}
+
+// a column of fixed size values, see CommitStore::write()
+template<typename T>
+static void writeColumn(QDataStream& _out, const QVector<T>& _column)
+{
+    _out << quint32(_column.size());
+    _out.writeRawData(reinterpret_cast<const char*>(_column.constData()), _column.size() * sizeof(T));
+}
+
+template<typename T>
+static bool readColumn(QDataStream& _in, QVector<T>& _column)
+{
+    quint32 size = 0;
+
+    _in >> size;
+
+    // the values are copied at once, not more than there is
+    if (_in.status() != QDataStream::Ok
+        || quint64(size) * sizeof(T) > quint64(_in.device()->bytesAvailable()))
+        return false;
+
+    _column.resize(size);
+
+    int bytes = size * sizeof(T);
+
+    return _in.readRawData(reinterpret_cast<char*>(_column.data()), bytes) == bytes;
+}
+
+// UTF-16 characters of _text
+static void writeText(QDataStream& _out, const QString& _text)
+{
+    _out << quint32(_text.size());
+    _out.writeRawData(reinterpret_cast<const char*>(_text.utf16()), _text.size() * sizeof(ushort));
+}
+
+static bool readText(QDataStream& _in, QString& _text)
+{
+    quint32 size = 0;
+
+    _in >> size;
+
+    if (_in.status() != QDataStream::Ok
+        || quint64(size) * sizeof(ushort) > quint64(_in.device()->bytesAvailable()))
+        return false;
+
+    _text.resize(size);
+
+    int bytes = size * sizeof(ushort);
+
+    return _in.readRawData(reinterpret_cast<char*>(_text.data()), bytes) == bytes;
+}
+
+quint64 CommitStore::fingerprint(const QStringList& _parts)
+{
+    // FNV-1a of the UTF-16 characters, each field is terminated by '#'
+    quint64 value = 14695981039346656037ull;
+    QString commentField = comment(_parts);
+
+    for (int f = 1; f < 6 && f < _parts.size(); f++)
+    {
+        const QString& field = (f == 5) ? commentField : _parts.at(f);
+        const ushort* data = field.utf16();
+
+        for (int i = 0; i < field.size(); i++)
+        {
+            value ^= data[i];
+            value *= 1099511628211ull;
+        }
+
+        value ^= '#';
+        value *= 1099511628211ull;
+    }
+
+    // 0 marks a row without information
+    return value ? value : 1;
+}
+
+QString CommitStore::comment(const QStringList& _parts)
+{
+    // the text behind the last '#' is the line end
+    if (_parts.size() <= 7)
+        return _parts.value(5);
+
+    return QStringList(_parts.mid(5, _parts.size() - 6)).join(QChar('#'));
+}
+
+int CommitStore::size() const
+{
+    return ids.size();
+}
+
+void CommitStore::clear()
+{
+    *this = CommitStore();
+}
+
+int CommitStore::find(const ObjectId& _id) const
+{
+    return rows.value(_id, -1);
+}
+
+int CommitStore::insert(const ObjectId& _id)
+{
+    QHash<ObjectId, int>::const_iterator it = rows.constFind(_id);
+
+    if (it != rows.constEnd())
+        return it.value();
+
+    int row = ids.size();
+
+    rows.insert(_id, row);
+    ids.push_back(_id);
+    fingerprints.push_back(0);
+    times.push_back(0);
+    dates.push_back(QString());
+    authors.push_back(intern(QString()));
+    decorations.push_back(intern(QString()));
+    commentOffsets.push_back(0);
+    commentLengths.push_back(0);
+    tags.push_back(QVector<int>());
+
+    return row;
+}
+
+int CommitStore::intern(const QString& _string)
+{
+    QHash<QString, int>::const_iterator it = stringIds.constFind(_string);
+
+    if (it != stringIds.constEnd())
+        return it.value();
+
+    int id = strings.size();
+
+    stringIds.insert(_string, id);
+    strings.push_back(_string);
+
+    return id;
+}
+
+const ObjectId& CommitStore::getObjectId(int _row) const
+{
+    return (_row >= 0) ? ids.at(_row) : nullId;
+}
+
+QString CommitStore::getHash(int _row) const
+{
+    return (_row >= 0) ? ids.at(_row).toString() : QString();
+}
+
+quint64 CommitStore::getFingerprint(int _row) const
+{
+    return (_row >= 0) ? fingerprints.at(_row) : 0;
+}
+
+qint64 CommitStore::getTime(int _row) const
+{
+    return (_row >= 0) ? times.at(_row) : 0;
+}
+
+const QString& CommitStore::getDate(int _row) const
+{
+    if (_row < 0)
+        return emptyString;
+
+    QString& date = dates[_row];
+
+    if (date.isEmpty())
+    {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+        date = QDateTime::fromSecsSinceEpoch(times.at(_row)).toString("yyyy.MM.dd HH:mm:ss");
+#else
+        date = QDateTime::fromTime_t(times.at(_row)).toString("yyyy.MM.dd HH:mm:ss");
+#endif
+    }
+
+    return date;
+}
+
+const QString& CommitStore::getAuthor(int _row) const
+{
+    return (_row >= 0) ? strings.at(authors.at(_row)) : emptyString;
+}
+
+const QString& CommitStore::getDecoration(int _row) const
+{
+    return (_row >= 0) ? strings.at(decorations.at(_row)) : emptyString;
+}
+
+QString CommitStore::getComment(int _row) const
+{
+    return (_row >= 0) ? commentText.mid(commentOffsets.at(_row), commentLengths.at(_row)) : QString();
+}
+
+QStringList CommitStore::getWrappedComment(int _row) const
+{
+    if (_row < 0)
+        return QStringList();
+
+    QStringList* cached = wrapCache.lines.object(_row);
+
+    if (cached)
+        return *cached;
+
+    QStringList lines = wrapComment(getComment(_row), wrapCache.columns, wrapCache.maxlen);
+    int cost = 1;
+
+    foreach(const QString& line, lines)
+    {
+        cost += line.size();
+    }
+
+    wrapCache.lines.insert(_row, new QStringList(lines), cost);
+
+    return lines;
+}
+
+void CommitStore::setCommentProperties(int _columns, int _maxlen)
+{
+    if (wrapCache.columns == _columns && wrapCache.maxlen == _maxlen)
+        return;
+
+    wrapCache.columns = _columns;
+    wrapCache.maxlen = _maxlen;
+    wrapCache.lines.clear();
+}
+
+QStringList CommitStore::wrapComment(const QString& _comment, int _columns, int _maxlen)
+{
+    QString info = _comment;
+
+    if (_maxlen)
+    {
+        info = _comment.mid(0, _maxlen);
+        if (_comment.size() > _maxlen)
+            info = info + "...";
+    }
+
+    QStringList lines;
+
+    int len = 0;
+    QString part;
+    QStringList tmp = info.split(' ');
+
+    foreach (const QString& str, tmp)
+    {
+        if (len == 0)
+        {
+            part = str;
+            len = str.size();
+        }
+        else if (_columns == 0 || len < _columns)
+        {
+            part = part + " " + str;
+            len += 1 + str.size();
+        }
+
+        if (_columns && len >= _columns)
+        {
+            lines.push_back(part);
+            part = QString();
+            len = 0;
+        }
+    }
+
+    if (len != 0)
+    {
+        lines.push_back(part);
+    }
+
+    return lines;
+}
+
+QString CommitStore::getInput(int _row) const
+{
+    if (_row < 0 || fingerprints.at(_row) == 0)
+        return QString();
+
+    return QString("#") + getHash(_row)
+           + "#" + QString::number(times.at(_row))
+           + "#" + getAuthor(_row)
+           + "#" + getDecoration(_row)
+           + "#" + getComment(_row) + "#";
+}
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+bool CommitStore::matchSearchFields(int _row, const QRegularExpression& _pattern, const QString& _text) const
+#else
+bool CommitStore::matchSearchFields(int _row, const QRegExp& _pattern, const QString& _text) const
+#endif
+{
+    if (_row < 0)
+        return false;
+
+    // the line of getInput() and the date like the former raw
+    // input, the capacity of the buffer is kept
+    searchText.resize(0);
+    searchText += QChar('#');
+    searchText += getHash(_row);
+    searchText += QChar('#');
+    searchText += QString::number(times.at(_row));
+    searchText += QChar('#');
+    searchText += getAuthor(_row);
+    searchText += QChar('#');
+    searchText += getDecoration(_row);
+    searchText += QChar('#');
+    searchText += QStringRef(&commentText, commentOffsets.at(_row), commentLengths.at(_row));
+    searchText += QString("# ");
+    searchText += getDate(_row);
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    return _pattern.isValid() ? _pattern.match(searchText).hasMatch() :
+        (searchText.indexOf(_text, 0) != -1);
+#else
+    return _pattern.isValid() ? (_pattern.indexIn(searchText, 0) != -1) :
+        (searchText.indexOf(_text, 0) != -1);
+#endif
+}
+
+void CommitStore::setInput(int _row,
+                           quint64 _fingerprint,
+                           qint64 _time,
+                           const QString& _author,
+                           const QString& _decoration,
+                           const QString& _comment)
+{
+    fingerprints[_row] = _fingerprint;
+    if (times.at(_row) != _time)
+        dates[_row].clear();
+    times[_row] = _time;
+    authors[_row] = intern(_author);
+    decorations[_row] = intern(_decoration);
+
+    // an unchanged comment stays where it is, wrapped, too
+    if (getComment(_row) != _comment)
+    {
+        deadComment += commentLengths.at(_row);
+        commentOffsets[_row] = commentText.size();
+        commentLengths[_row] = _comment.size();
+        commentText += _comment;
+        wrapCache.lines.remove(_row);
+
+        if (deadComment > deadCommentMin && deadComment * 2 > commentText.size())
+            compactComments();
+    }
+
+    tags[_row] = QVector<int>();
+}
+
+void CommitStore::compactComments()
+{
+    QString text;
+
+    text.reserve(commentText.size() - deadComment);
+    for (int row = 0; row < ids.size(); row++)
+    {
+        int offset = text.size();
+
+        text += QStringRef(&commentText, commentOffsets.at(row), commentLengths.at(row));
+        commentOffsets[row] = offset;
+    }
+
+    commentText = text;
+    deadComment = 0;
+}
+
+void CommitStore::addTag(int _row, const QString& _key, const QString& _value)
+{
+    QVector<int>& t = tags[_row];
+
+    t.push_back(intern(_key));
+    t.push_back(intern(_value));
+}
+
+QStringList CommitStore::getKeys(int _row) const
+{
+    if (_row < 0)
+        return QStringList();
+
+    QStringList keys = QStringList()
+        << hashKey << dateKey << authorKey << commentRawKey << commentKey;
+
+    const QVector<int>& t = tags.at(_row);
+
+    for (int i = 0; i < t.size(); i += 2)
+    {
+        const QString& key = strings.at(t.at(i));
+
+        if (!keys.contains(key))
+            keys.push_back(key);
+    }
+
+    // same order as the keys of a QMap
+    std::sort(keys.begin(), keys.end());
+
+    return keys;
+}
+
+QStringList CommitStore::getValues(int _row, const QString& _key) const
+{
+    if (_row < 0)
+        return QStringList();
+
+    if (_key == commentKey)
+        return getWrappedComment(_row);
+    if (_key == dateKey)
+        return QStringList(getDate(_row));
+    if (_key == authorKey)
+        return QStringList(getAuthor(_row));
+    if (_key == commentRawKey)
+        return QStringList(getComment(_row));
+    if (_key == hashKey)
+        return QStringList(getHash(_row));
+    if (_key == inputKey)
+        return QStringList(getInput(_row));
+
+    QStringList values;
+    const QVector<int>& t = tags.at(_row);
+
+    if (t.isEmpty())
+        return values;
+
+    // an unknown key has no id, nothing to intern here
+    int keyId = stringIds.value(_key, -1);
+
+    for (int i = 0; i < t.size(); i += 2)
+    {
+        if (t.at(i) == keyId)
+            values.push_back(strings.at(t.at(i + 1)));
+    }
+
+    return values;
+}
+
+QMap<QString, QStringList> CommitStore::getKeyInformation(int _row) const
+{
+    QMap<QString, QStringList> keyInformation;
+
+    foreach(const QString& key, getKeys(_row))
+    {
+        if (key != commentKey)
+            keyInformation.insert(key, getValues(_row, key));
+    }
+
+    if (_row >= 0)
+        keyInformation.insert(inputKey, getValues(_row, inputKey));
+
+    return keyInformation;
+}
+
+int CommitStore::copyRow(const CommitStore& _other, int _row)
+{
+    int row = insert(_other.ids.at(_row));
+
+    fingerprints[row] = _other.fingerprints.at(_row);
+    times[row] = _other.times.at(_row);
+    dates[row] = _other.dates.at(_row);
+    authors[row] = intern(_other.getAuthor(_row));
+    decorations[row] = intern(_other.getDecoration(_row));
+
+    deadComment += commentLengths.at(row);
+    commentOffsets[row] = commentText.size();
+    commentLengths[row] = _other.commentLengths.at(_row);
+    commentText += QStringRef(&_other.commentText, _other.commentOffsets.at(_row), _other.commentLengths.at(_row));
+
+    QVector<int> t;
+
+    foreach(int id, _other.tags.at(_row))
+    {
+        t.push_back(intern(_other.strings.at(id)));
+    }
+    tags[row] = t;
+
+    return row;
+}
+
+void CommitStore::write(QDataStream& _out) const
+{
+    writeColumn(_out, ids);
+    writeColumn(_out, fingerprints);
+    writeColumn(_out, times);
+    writeColumn(_out, authors);
+    writeColumn(_out, decorations);
+    writeColumn(_out, commentOffsets);
+    writeColumn(_out, commentLengths);
+
+    // the strings as lengths and one text
+    QVector<int> stringLengths;
+    QString stringText;
+
+    foreach(const QString& str, strings)
+    {
+        stringLengths.push_back(str.size());
+        stringText += str;
+    }
+
+    writeColumn(_out, stringLengths);
+    writeText(_out, stringText);
+    writeText(_out, commentText);
+
+    // the tags as number per row and one list of ids
+    QVector<int> tagCounts;
+    QVector<int> tagIds;
+
+    foreach(const QVector<int>& t, tags)
+    {
+        tagCounts.push_back(t.size());
+        tagIds += t;
+    }
+
+    writeColumn(_out, tagCounts);
+    writeColumn(_out, tagIds);
+}
+
+bool CommitStore::read(QDataStream& _in)
+{
+    CommitStore store;
+    QVector<int> stringLengths;
+    QString stringText;
+    QVector<int> tagCounts;
+    QVector<int> tagIds;
+
+    if (!readColumn(_in, store.ids)
+        || !readColumn(_in, store.fingerprints)
+        || !readColumn(_in, store.times)
+        || !readColumn(_in, store.authors)
+        || !readColumn(_in, store.decorations)
+        || !readColumn(_in, store.commentOffsets)
+        || !readColumn(_in, store.commentLengths)
+        || !readColumn(_in, stringLengths)
+        || !readText(_in, stringText)
+        || !readText(_in, store.commentText)
+        || !readColumn(_in, tagCounts)
+        || !readColumn(_in, tagIds))
+        return false;
+
+    int size = store.ids.size();
+
+    if (store.fingerprints.size() != size || store.times.size() != size
+        || store.authors.size() != size || store.decorations.size() != size
+        || store.commentOffsets.size() != size || store.commentLengths.size() != size
+        || tagCounts.size() != size)
+        return false;
+
+    // the strings
+    int pos = 0;
+
+    foreach(int length, stringLengths)
+    {
+        if (length < 0 || pos + length > stringText.size())
+            return false;
+
+        store.stringIds.insert(stringText.mid(pos, length), store.strings.size());
+        store.strings.push_back(stringText.mid(pos, length));
+        pos += length;
+    }
+
+    // the rows, all ids refer to the strings and the comment buffer
+    int tag = 0;
+
+    store.dates.resize(size);
+    store.tags.resize(size);
+
+    for (int row = 0; row < size; row++)
+    {
+        if (store.authors.at(row) < 0 || store.authors.at(row) >= store.strings.size()
+            || store.decorations.at(row) < 0 || store.decorations.at(row) >= store.strings.size()
+            || store.commentOffsets.at(row) < 0 || store.commentLengths.at(row) < 0
+            || store.commentOffsets.at(row) + store.commentLengths.at(row) > store.commentText.size()
+            || tagCounts.at(row) < 0 || tag + tagCounts.at(row) > tagIds.size())
+            return false;
+
+        for (int i = tag; i < tag + tagCounts.at(row); i++)
+        {
+            if (tagIds.at(i) < 0 || tagIds.at(i) >= store.strings.size())
+                return false;
+        }
+
+        store.tags[row] = tagIds.mid(tag, tagCounts.at(row));
+        tag += tagCounts.at(row);
+
+        store.rows.insert(store.ids.at(row), row);
+        store.deadComment -= store.commentLengths.at(row);
+    }
+
+    // overlapping comments are counted twice
+    store.deadComment = qMax(0, store.deadComment + store.commentText.size());
+
+    // the comment properties stay
+    store.wrapCache = wrapCache;
+    *this = store;
+
+    return true;
+}
@@ -0,0 +1,230 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#ifndef __COMMITSTORE_H__
+#define __COMMITSTORE_H__
+
+#include <QCache>
+#include <QDataStream>
+#include <QHash>
+#include <QMap>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QRegularExpression>
+#else
+#include <QRegExp>
+#endif
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtGlobal>
+
+#include "objectid.h"
+
+/**
+ * \brief Columnar storage of the git log information of all commits.
+ *        A Version only holds its row, the columns keep the binary
+ *        object id, the commit time, the interned author and
+ *        decoration, the comment as offset into one text buffer and
+ *        the tags as list of interned key and value ids. Key names,
+ *        authors and tags are stored once.
+ *        The comments are wrapped on demand, see getWrappedComment().
+ *        The raw git log line is not kept, a reload is detected as
+ *        change by a 64 bit fingerprint of the stored fields.
+ *        Rows are not removed, a commit loaded again reuses its row,
+ *        a complete load copies the rows still used to a new store,
+ *        see copyRow().
+ *        The columns are implicitly shared, so a copy handed to the
+ *        GitLogWorker is cheap and detaches when it is changed.
+ */
+class CommitStore
+{
+public:
+    // keys of the fixed columns
+    static const QString inputKey;
+    static const QString hashKey;
+    static const QString dateKey;
+    static const QString authorKey;
+    static const QString commentKey;
+    static const QString commentRawKey;
+
+    CommitStore();
+
+    // fingerprint of the fields hash, time, author, decoration and
+    // comment of a git log line split at '#', never 0. The line end
+    // behind the last '#' is not part of it, so a line assembled by
+    // getInput() has the same fingerprint.
+    static quint64 fingerprint(const QStringList& _parts);
+
+    // the comment field of a git log line split at '#', the parts
+    // of a comment which contains '#' are joined again
+    static QString comment(const QStringList& _parts);
+
+    int size() const;
+    void clear();
+
+    // row of _id or -1
+    int find(const ObjectId& _id) const;
+
+    // row of _id, an empty row is added if it is unknown
+    int insert(const ObjectId& _id);
+
+    // id of _string, it is added if it is unknown
+    int intern(const QString& _string);
+
+    const ObjectId& getObjectId(int _row) const;
+
+    // hex string of the object id
+    QString getHash(int _row) const;
+
+    // 0 for a row without information
+    quint64 getFingerprint(int _row) const;
+
+    qint64 getTime(int _row) const;
+
+    // formatted when it is needed first
+    const QString& getDate(int _row) const;
+    const QString& getAuthor(int _row) const;
+
+    // the ref names of git log %d, e.g. " (HEAD -> master)"
+    const QString& getDecoration(int _row) const;
+    QString getComment(int _row) const;
+
+    /**
+     * \brief The comment of _row wrapped and limited by the comment
+     *        properties. The lines are computed when they are needed
+     *        first, e.g. to paint a version, and cached. The least
+     *        recently used ones are dropped, i.e. those of versions
+     *        which are off screen.
+     */
+    QStringList getWrappedComment(int _row) const;
+
+    // the comment properties of MainWindow, the cached lines are
+    // dropped if they change
+    void setCommentProperties(int _columns, int _maxlen);
+
+    // split _comment into lines of about _columns characters, it is
+    // cut at _maxlen characters, 0 is unlimited
+    static QStringList wrapComment(const QString& _comment, int _columns, int _maxlen);
+
+    // the git log line "#hash#time#author#decoration#comment#"
+    // assembled from the columns
+    QString getInput(int _row) const;
+
+    /**
+     * \brief true, if the text searched by Version::findMatch(), the
+     *        git log line of getInput() followed by the date, matches
+     *        _pattern or, if it is invalid, contains _text. A pattern
+     *        may span several fields. The text is assembled in a buffer
+     *        which is reused for all rows.
+     */
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    bool matchSearchFields(int _row, const QRegularExpression& _pattern, const QString& _text) const;
+#else
+    bool matchSearchFields(int _row, const QRegExp& _pattern, const QString& _text) const;
+#endif
+
+    /**
+     * \brief Replace the information of _row by the fields of the git
+     *        log line with the fingerprint _fingerprint, the tags are
+     *        removed.
+     */
+    void setInput(int _row,
+                  quint64 _fingerprint,
+                  qint64 _time,
+                  const QString& _author,
+                  const QString& _decoration,
+                  const QString& _comment);
+    void addTag(int _row, const QString& _key, const QString& _value);
+
+    // keys with information in _row, sorted
+    QStringList getKeys(int _row) const;
+
+    // the values of _key in _row
+    QStringList getValues(int _row, const QString& _key) const;
+
+    // all information of _row as key to values including the
+    // git log line, but not the wrapped comment
+    QMap<QString, QStringList> getKeyInformation(int _row) const;
+
+    // copy the information of _row of _other, the strings are
+    // interned in this store, returns the row in this store
+    int copyRow(const CommitStore& _other, int _row);
+
+    /**
+     * \brief Write all columns as they are in memory, e.g. for the
+     *        GraphSnapshot. They are read again on the same machine
+     *        only, the byte order is the native one.
+     */
+    void write(QDataStream& _out) const;
+
+    // replace the store by the columns written by write(), false on error
+    bool read(QDataStream& _in);
+
+private:
+    // object ids and their rows
+    QVector<ObjectId> ids;
+    QHash<ObjectId, int> rows;
+
+    // interned strings and their ids
+    QVector<QString> strings;
+    QHash<QString, int> stringIds;
+
+    QVector<quint64> fingerprints;
+    QVector<qint64> times;
+
+    // times formatted by getDate(), empty until then
+    mutable QVector<QString> dates;
+    QVector<int> authors;
+    QVector<int> decorations;
+
+    // comments in one buffer, a changed comment is appended,
+    // deadComment counts the characters no row refers to
+    QString commentText;
+    QVector<int> commentOffsets;
+    QVector<int> commentLengths;
+    int deadComment;
+
+    // drop the replaced comments from the buffer
+    void compactComments();
+
+    // wrapped comments by row, a copy of the store starts empty,
+    // so the copy of a GitLogWorker does not share it
+    class WrapCache
+    {
+    public:
+        WrapCache();
+        WrapCache(const WrapCache& _other);
+        WrapCache& operator=(const WrapCache& _other);
+
+        int columns;
+        int maxlen;
+
+        // the cost is the number of characters
+        QCache<int, QStringList> lines;
+    };
+
+    mutable WrapCache wrapCache;
+
+    // text of matchSearchFields()
+    mutable QString searchText;
+
+    // pairs of key and value ids, empty for most commits
+    QVector<QVector<int> > tags;
+};
+
+#endif
@@ -19,17 +19,23 @@
 
 #include <QMenu>
 #include <QFileInfo>
+#include <QDateTime>
+#include <QCryptographicHash>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QMimeDatabase>
+#endif
 #include <QClipboard>
 #include <QApplication>
 #include "comparetree.h"
 #include "execute_cmd.h"
 #include "mainwindow.h"
 #include "graphwidget.h"
+#include "gittreemodel.h"
 #include <unistd.h>
 
 using namespace std;
 
-CompareTree::CompareTree(QWidget* _parent) : QTreeView(_parent)
+CompareTree::CompareTree(QWidget* _parent) : QTreeView(_parent), objectIdLength(40)
 {
     setContextMenuPolicy(Qt::CustomContextMenu);
 
@@ -37,43 +43,14 @@ CompareTree::CompareTree(QWidget* _parent) : QTreeView(_parent)
             this, SLOT(onCustomContextMenu(const QPoint&)));
 }
 
-void CompareTree::compareHashes(const QStringList& _hash1, const QString& _hash2, bool _showDiff)
+void CompareTree::addNameStatusLines(QStandardItem* _root,
+                                     const QList<QString>& _lines,
+                                     bool _showDiff,
+                                     QStandardItem*& _showDiffItem) const
 {
-    QStandardItem* showDiffItem = NULL;
-
-    QStandardItemModel* treemodel = new QStandardItemModel(NULL);
-
-    treemodel->setHorizontalHeaderItem(0, new QStandardItem(QString("Path")));
-    treemodel->setHorizontalHeaderItem(1, new QStandardItem(QString("File")));
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    header()->setSectionResizeMode(QHeaderView::Stretch);
-#else
-    header()->setResizeMode(QHeaderView::Stretch);
-#endif
-
-    QStandardItem* root = treemodel->invisibleRootItem();
-    root->setEditable(false);
-
-    // get changed files
-    QList<QString> cache;
-    foreach(QString it, _hash1)
-    {
-        QString cmd = "git -C " + graph->getLocalRepositoryPath() + " diff " + it + ".." + _hash2 + " --name-status";
-
-        execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-    }
-
-    // copy diff output to clipboard
-    {
-        QStringList clipboard(cache);
-        QApplication::clipboard()->setText(clipboard.join(""), QClipboard::Clipboard);
-        QApplication::clipboard()->setText(clipboard.join(""), QClipboard::Selection);
-    }
-
     // now copy the path information into a nice tree widget, duplicates are removed
-    for (QStringList::iterator jt = cache.begin();
-         jt != cache.end();
+    for (QList<QString>::const_iterator jt = _lines.begin();
+         jt != _lines.end();
          ++jt)
     {
         QString info = (*jt).trimmed();
@@ -134,7 +111,7 @@ void CompareTree::compareHashes(const QStringList& _hash1, const QString& _hash2
         QStringList path_elements = path.split(QChar('/'));
 
         // start with root node...
-        QStandardItem* p = root;
+        QStandardItem* p = _root;
 
         for (QStringList::iterator it = path_elements.begin();
              it != path_elements.end();
@@ -186,7 +163,7 @@ void CompareTree::compareHashes(const QStringList& _hash1, const QString& _hash2
 
                     if (_showDiff == true && graph->getFileConstraint() == path)
                     {
-                        showDiffItem = actitem;
+                        _showDiffItem = actitem;
                     }
                 }
                 else
@@ -198,6 +175,55 @@ void CompareTree::compareHashes(const QStringList& _hash1, const QString& _hash2
             }
         }
     }
+}
+
+void CompareTree::compareHashes(const QStringList& _hash1, const QString& _hash2, bool _showDiff)
+{
+    QStandardItem* showDiffItem = NULL;
+
+    QStandardItemModel* treemodel = new QStandardItemModel(NULL);
+
+    treemodel->setHorizontalHeaderItem(0, new QStandardItem(QString("Path")));
+    treemodel->setHorizontalHeaderItem(1, new QStandardItem(QString("File")));
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    header()->setSectionResizeMode(QHeaderView::Stretch);
+#else
+    header()->setResizeMode(QHeaderView::Stretch);
+#endif
+
+    QStandardItem* root = treemodel->invisibleRootItem();
+    root->setEditable(false);
+
+    // get changed files, the diffs run concurrently and each output
+    // is copied into the tree as soon as it is available
+    QList<QStringList> cmds;
+
+    foreach(QString it, _hash1)
+    {
+        cmds.push_back(QStringList()
+                       << "git" << "-C" << graph->getLocalRepositoryPath()
+                       << "diff" << it + ".." + _hash2 << "--name-status");
+    }
+
+    QList<QString> cache;
+
+    execute_cmds(
+        cmds,
+        [this, root, _showDiff, &cache, &showDiffItem](int, int, const QList<QString>& _output)
+        {
+            cache += _output;
+            addNameStatusLines(root, _output, _showDiff, showDiffItem);
+        },
+        mwin->getPrintCmdToStdout());
+
+    // copy diff output to clipboard
+    {
+        QStringList clipboard(cache);
+        QApplication::clipboard()->setText(clipboard.join(""), QClipboard::Clipboard);
+        QApplication::clipboard()->setText(clipboard.join(""), QClipboard::Selection);
+    }
+
     setModel(treemodel);
     expandTree();
 
@@ -239,7 +265,9 @@ void CompareTree::expandTree()
 {
     if (graph->getFileConstraint().isEmpty())
     {
-        expandToDepth(10);
+        // expanding would read the complete version tree
+        if (dynamic_cast<GitTreeModel*>(model()) == NULL)
+            expandToDepth(10);
     }
     else
     {
@@ -260,6 +288,10 @@ void CompareTree::expandTree()
              ++it)
         {
 
+            // load a folder of a version tree
+            if (treemodel->canFetchMore(p->index()))
+                treemodel->fetchMore(p->index());
+
             for (int i = 0; i < p->rowCount(); i++)
             {
                 QStandardItem* t = p->child(i);
@@ -470,12 +502,23 @@ void CompareTree::setGraphWidget(class GraphWidget* _graph)
 
 void CompareTree::viewLocalChanges(bool _staged)
 {
-    // get data
-    QString cmd = "git -C " + graph->getLocalRepositoryPath() + (_staged == true ? " diff --cached --name-only" : " ls-files -m");
-
+    // get data, from the last git status, if no file has changed since
+    const StatusEngine* status = mwin->getStatusEngine();
     QList<QString> cache;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
+    if (status->isCurrent())
+        cache = _staged ? status->getStagedFiles() : status->getModifiedFiles();
+    else
+    {
+        QStringList cmd = QStringList() << "git" << "-C" << graph->getLocalRepositoryPath();
+
+        if (_staged == true)
+            cmd << "diff" << "--cached" << "--name-only";
+        else
+            cmd << "ls-files" << "-m";
+
+        execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
+    }
 
     QStandardItemModel* treemodel = new QStandardItemModel(NULL);
 
@@ -557,14 +600,8 @@ void CompareTree::viewLocalChanges(bool _staged)
 
 void CompareTree::viewThisVersion(const QString& _hash)
 {
-    // get data
-    QString cmd = "git -C " + graph->getLocalRepositoryPath() + " ls-tree --full-tree --name-only -r " + _hash;
-
-    QList<QString> cache;
-
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-
-    QStandardItemModel* treemodel = new QStandardItemModel(NULL);
+    // folders are read when they are expanded
+    GitTreeModel* treemodel = new GitTreeModel(graph->getCatFile(), NULL);
 
     treemodel->setHorizontalHeaderItem(0, new QStandardItem(QString("Path")));
     treemodel->setHorizontalHeaderItem(1, new QStandardItem(QString("File")));
@@ -575,67 +612,8 @@ void CompareTree::viewThisVersion(const QString& _hash)
     header()->setResizeMode(QHeaderView::Stretch);
 #endif
 
-    QStandardItem* root = treemodel->invisibleRootItem();
-    root->setEditable(false);
-
-    // now copy the path information into a nice tree widget
-    for (QStringList::iterator jt = cache.begin();
-         jt != cache.end();
-         ++jt)
-    {
-        QString path = (*jt).trimmed();
-
-        // split file path into a QStringList
-        QStringList path_elements = path.split(QChar('/'));
-
-        // start with root node...
-        QStandardItem* p = root;
-
-        for (QStringList::iterator it = path_elements.begin();
-             it != path_elements.end();
-             ++it)
-        {
-            // check all childs if the entry already exists
-            bool skip = false;
-            for (int i = 0; i < p->rowCount(); i++)
-            {
-                QStandardItem* t = p->child(i);
-                if (t->text() == *it)
-                {
-                    p = t;
-                    skip = true;
-                    break;
-                }
-            }
-
-            if (skip == false)
-            {
-                QList<QStandardItem*> columns;
-                // add new node under p
-                QStandardItem* t = new QStandardItem(*it);
-                t->setEditable(false);
-
-                QStringList::iterator kt = it;
-                ++kt;
-                if (kt == path_elements.end())
-                {
-                    columns << t;
-                    QStandardItem* actitem = new QStandardItem(path);
-                    actitem->setEditable(false);
-                    actitem->setData("X", Qt::UserRole + 1);
-                    actitem->setData(path, Qt::UserRole + 2);
-                    columns << actitem;
-                    p->appendRow(columns);
-                }
-                else
-                {
-                    t->setIcon(QIcon().fromTheme("folder")); // folder-open
-                    p->appendRow(t);
-                    p = t;
-                }
-            }
-        }
-    }
+    treemodel->invisibleRootItem()->setEditable(false);
+    treemodel->setVersion(_hash);
 
     setModel(treemodel);
     expandTree();
@@ -645,11 +623,18 @@ QString CompareTree::createTempVersionFile(const QString& _hash, const QString&
 {
     QString extension = getFileExtension(_path);
     QString fname = QString("%1/%2_%3.%4").arg(mwin->getTempPath()).arg(_hash).arg(getpid()).arg(extension);
-    QString cmd = "git -C " + graph->getLocalRepositoryPath() + " show " + _hash + ":" + _path + " > " + fname;
 
-    QList<QString> dummy;
+    // no process per file, the blob is read by the cat-file co-process
+    QByteArray oid;
+    QByteArray type;
+    qint64 size;
 
-    execute_cmd(cmd.toUtf8().data(), dummy, mwin->getPrintCmdToStdout());
+    graph->getCatFile()->readToFile(_hash + ":" + _path, fname);
+    if (graph->getCatFile()->info(_hash + ":" + _path, oid, type, size))
+    {
+        tempFileBlobs[fname] = oid;
+        objectIdLength = oid.size();
+    }
 
     mwin->addToCleanupFiles(fname);
 
@@ -667,51 +652,56 @@ void CompareTree::compareFileVersions(
 
     bool compareToLocalCurrent = mwin->getDiffLocalFiles();
 
-    // diffFiles will contain all temp file paths of the files to compare
-    QStringList diffFiles;
+    // versions "<hash>:<path>" to compare
+    QStringList objects;
 
     QSet<Version*> predecessors = graph->getPredecessors();
 
     foreach(Version * it, predecessors)
     {
-        diffFiles.push_back(createTempVersionFile(it->getHash(), _path_old));
+        objects.push_back(it->getHash() + ":" + _path_old);
     }
 
     if (_status != "D" && graph->getToHash().size())
-        diffFiles.push_back(createTempVersionFile(graph->getToHash(), _path));
+        objects.push_back(graph->getToHash() + ":" + _path);
 
-    if (diffFiles.size() == 0)
+    if (objects.size() == 0)
         compareToLocalCurrent = true;
 
-    // if local file is identical to a file from diffFiles, ignore it
-    if (compareToLocalCurrent || (graph->getToHash().size() == 0))
-    {
-        QString localFile = graph->getLocalRepositoryPath() + "/" + _path;
+    QString localFile = graph->getLocalRepositoryPath() + "/" + _path;
+    bool withLocalFile = (compareToLocalCurrent || (graph->getToHash().size() == 0))
+                         && QFile::exists(localFile);
 
-        if (QFile::exists(localFile))
+    // diffFiles will contain all temp file paths of the files to compare
+    QStringList diffFiles;
+
+    foreach(const QString& object, objects)
+    {
+        // if local file is identical to a version, it is not extracted
+        if (withLocalFile)
         {
+            QByteArray oid;
+            QByteArray type;
+            qint64 size;
 
-            QStringList tmp;
-            foreach(QString fname, diffFiles)
-            {
-                QString cmd = "diff " + fname + " " + localFile;
+            if (graph->getCatFile()->info(object, oid, type, size)
+                && oid == getLocalBlobId(localFile, oid.size()))
+                continue;
+        }
 
-                QList<QString> cache;
+        int sep = object.indexOf(':');
 
-                execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-                if (cache.size())
-                    tmp.push_back(fname);
-            }
-            diffFiles = tmp;
-            diffFiles.push_back(localFile);
-        }
+        diffFiles.push_back(createTempVersionFile(object.left(sep), object.mid(sep + 1)));
     }
 
+    if (withLocalFile)
+        diffFiles.push_back(localFile);
+
     // mime type to tool
     QString difftool;
     QString dummy;
 
-    mwin->getMimeTypeTools(getMimeType(diffFiles.front()), difftool, dummy);
+    mwin->getMimeTypeTools(getMimeTypes(diffFiles.front()), difftool, dummy);
 
     // drop empty files
     {
@@ -734,26 +724,107 @@ void CompareTree::compareFileVersions(
 void CompareTree::editCurrentVersion(const QString& _path)
 {
     QString tmp = graph->getLocalRepositoryPath() + "/" + _path;
-    QString mimeType = getMimeType(tmp);
+    QStringList mimeTypes = getMimeTypes(tmp);
     QString dummy;
     QString edittool;
 
-    mwin->getMimeTypeTools(mimeType, dummy, edittool);
+    mwin->getMimeTypeTools(mimeTypes, dummy, edittool);
     edittool.replace("%1", tmp);
     system(edittool.toUtf8().data());
 }
 
-QString CompareTree::getMimeType(const QString& _path) const
+QByteArray CompareTree::getLocalBlobId(const QString& _path, int _length) const
+{
+    QFileInfo fi(_path);
+    QMap<QString, LocalBlob>::const_iterator cached = localBlobs.constFind(_path);
+
+    if (cached != localBlobs.constEnd()
+        && cached.value().size == fi.size()
+        && cached.value().lastModified == fi.lastModified()
+        && cached.value().oid.size() == _length)
+        return cached.value().oid;
+
+    QFile file(_path);
+
+    if (!fi.isFile() || !file.open(QIODevice::ReadOnly))
+        return QByteArray();
+
+    // git object id: hash of "blob <size>\0<content>"
+    QCryptographicHash hash(_length == 64 ? QCryptographicHash::Sha256 : QCryptographicHash::Sha1);
+
+    hash.addData(QByteArray("blob ") + QByteArray::number(fi.size()) + '\0');
+
+    while (!file.atEnd())
+    {
+        QByteArray data = file.read(65536);
+
+        if (data.isEmpty())
+            return QByteArray();
+
+        hash.addData(data);
+    }
+
+    LocalBlob blob;
+
+    blob.size = fi.size();
+    blob.lastModified = fi.lastModified();
+    blob.oid = hash.result().toHex();
+    localBlobs[_path] = blob;
+
+    return blob.oid;
+}
+
+QStringList CompareTree::getMimeTypes(const QString& _path) const
 {
-    QString cmd = "file --mime-type -b " + _path;
+    // same content and extension, same mime types: the blob id
+    // is the same for all versions of a file which did not change it
+    QByteArray blob = tempFileBlobs.value(_path);
+
+    if (blob.isEmpty())
+        blob = getLocalBlobId(_path, objectIdLength);
+
+    QString key = QString::fromLatin1(blob) + "." + getFileExtension(_path);
+
+    // not readable, the path is all there is
+    if (blob.isEmpty())
+        key = _path;
+
+    QMap<QString, QStringList>::const_iterator cached = mimeTypeCache.constFind(key);
+
+    if (cached != mimeTypeCache.constEnd())
+        return cached.value();
+
+    QStringList mimeTypes;
+
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    // file extension first, the content is only read if the
+    // extension is unknown or ambiguous
+    static QMimeDatabase db;
+    QMimeType mimeType = db.mimeTypeForFile(_path);
+
+    // the aliases contain the names "file --mime-type" of former
+    // versions reported, a tool of a more general type, e.g.
+    // text/plain, is found by the ancestors
+    mimeTypes << mimeType.name() << mimeType.aliases();
+
+    foreach(const QString& name, mimeType.allAncestors())
+    {
+        mimeTypes << name << db.mimeTypeForName(name).aliases();
+    }
+    mimeTypes.removeDuplicates();
+#else
+    QStringList cmd = QStringList() << "file" << "--mime-type" << "-b" << _path;
     QList<QString> cache;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
+    execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
 
     if (cache.size())
-        return cache.at(0);
+        mimeTypes << cache.at(0).trimmed();
+#endif
 
-    return QString();
+    mimeTypeCache[key] = mimeTypes;
+
+    return mimeTypes;
 }
 
 QString CompareTree::getFileExtension(const QString& _path) const
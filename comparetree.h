@@ -23,6 +23,8 @@
 #include <QWidget>
 #include <QAction>
 #include <QString>
+#include <QMap>
+#include <QDateTime>
 
 /**
  * \brief CompareTree is a QTreeView widget
@@ -66,10 +68,19 @@ public:
     void compareFileVersionsAction(QStringList& _tmp);
 
 protected:
+    // add the files of git diff --name-status lines to the tree below _root
+    void addNameStatusLines(QStandardItem* _root,
+                            const QList<QString>& _lines,
+                            bool _showDiff,
+                            QStandardItem*& _showDiffItem) const;
+
     // called by compareFileVersions to create temporary files
     QString createTempVersionFile(const QString& _hash, const QString& _path) const;
-    // get mime type
-    QString getMimeType(const QString& _path) const;
+    // git blob id of a local file with _length hex digits
+    QByteArray getLocalBlobId(const QString& _path, int _length) const;
+    // mime type names of _path, the preferred one first,
+    // followed by its aliases and its ancestors with their aliases
+    QStringList getMimeTypes(const QString& _path) const;
     // get file extension
     QString getFileExtension(const QString& _path) const;
 
@@ -90,6 +101,22 @@ public slots:
 protected:
     class MainWindow* mwin;
     class GraphWidget* graph;
+
+    // blob ids of the temporary files
+    mutable QMap<QString, QByteArray> tempFileBlobs;
+    // hex digits of the blob ids of the repository
+    mutable int objectIdLength;
+    // mime types per blob id and file extension
+    mutable QMap<QString, QStringList> mimeTypeCache;
+
+    // blob ids of local files, valid while size and time stamp are unchanged
+    struct LocalBlob
+    {
+        qint64 size;
+        QDateTime lastModified;
+        QByteArray oid;
+    };
+    mutable QMap<QString, LocalBlob> localBlobs;
 };
 
 #endif
@@ -15,25 +15,431 @@
 /*                                               */
 /* --------------------------------------------- */
 
-#include <stdio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <spawn.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include <iostream>
 
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <QWaitCondition>
+
 #include "execute_cmd.h"
 
-void execute_cmd(const char* _cmd, QList<QString>& _output, bool _log)
+extern char** environ;
+
+// command line for the log output
+static QString cmdLine(const QStringList& _argv)
+{
+    QStringList tmp;
+
+    foreach (const QString& arg, _argv)
+    {
+        if (arg.isEmpty() || arg.contains(QChar(' ')) || arg.contains(QChar('"')))
+            tmp.push_back("\"" + arg + "\"");
+        else
+            tmp.push_back(arg);
+    }
+    return tmp.join(QChar(' '));
+}
+
+// start _argv with stdout redirected to _stdoutFd and stdin to
+// _stdinFd, all descriptors of the parent are created with O_CLOEXEC
+static pid_t spawn(const QStringList& _argv, int _stdoutFd, int _stdinFd = -1)
+{
+    if (_argv.isEmpty())
+        return -1;
+
+    QList<QByteArray> args;
+    QVector<char*> argv;
+
+    foreach (const QString& arg, _argv)
+    {
+        args.push_back(arg.toLocal8Bit());
+    }
+    for (int i = 0; i < args.size(); i++)
+    {
+        argv.push_back(args[i].data());
+    }
+    argv.push_back(NULL);
+
+    posix_spawn_file_actions_t actions;
+
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_adddup2(&actions, _stdoutFd, 1);
+    if (_stdinFd != -1)
+        posix_spawn_file_actions_adddup2(&actions, _stdinFd, 0);
+
+    pid_t pid = -1;
+
+    if (posix_spawnp(&pid, argv.at(0), &actions, NULL, argv.data(), environ) != 0)
+        pid = -1;
+
+    posix_spawn_file_actions_destroy(&actions);
+
+    return pid;
+}
+
+static int waitForExit(pid_t _pid)
+{
+    int status = 0;
+
+    while (waitpid(_pid, &status, 0) == -1)
+    {
+        if (errno != EINTR)
+            return -1;
+    }
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+// write all of _data to _fd, a command which has exited
+// must not terminate gvtree by SIGPIPE
+static bool writeInput(int _fd, const QByteArray& _data)
+{
+    sigset_t pipeSet;
+    sigset_t oldSet;
+
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+    const char* data = _data.constData();
+    qint64 left = _data.size();
+    bool ok = true;
+
+    while (left > 0)
+    {
+        ssize_t len = write(_fd, data, left);
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len <= 0)
+        {
+            ok = false;
+            break;
+        }
+
+        data += len;
+        left -= len;
+    }
+
+    if (!ok && errno == EPIPE)
+    {
+        struct timespec zero = {0, 0};
+
+        sigtimedwait(&pipeSet, NULL, &zero);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldSet, NULL);
+
+    return ok;
+}
+
+int execute_cmd(const QStringList& _argv,
+                const std::function<bool(const QByteArray&)>& _lineHandler,
+                bool _log)
+{
+    return execute_cmd(_argv, QByteArray(), _lineHandler, _log);
+}
+
+int execute_cmd(const QStringList& _argv,
+                const QByteArray& _input,
+                const std::function<bool(const QByteArray&)>& _lineHandler,
+                bool _log)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+
+    if (_log)
+        std::cout << cmdLine(_argv).toUtf8().data() << (_input.isNull() ? "" : " < stdin") << std::endl;
+
+    // close on exec, so commands started by other threads
+    // do not keep the pipe open
+    int fd[2];
+    int in[2] = {-1, -1};
+
+    if (pipe2(fd, O_CLOEXEC) != 0)
+        return -1;
+
+    if (!_input.isNull() && pipe2(in, O_CLOEXEC) != 0)
+    {
+        close(fd[0]);
+        close(fd[1]);
+        return -1;
+    }
+
+    pid_t pid = spawn(_argv, fd[1], in[0]);
+
+    close(fd[1]);
+    if (in[0] != -1)
+        close(in[0]);
+
+    if (pid == -1)
+    {
+        close(fd[0]);
+        if (in[1] != -1)
+            close(in[1]);
+        std::cerr << "Error: Could not run " << cmdLine(_argv).toUtf8().data() << std::endl;
+        return -1;
+    }
+
+    // the input is written completely before the output is read,
+    // the command has to read all of its input first, like git --stdin
+    if (in[1] != -1)
+    {
+        writeInput(in[1], _input);
+        close(in[1]);
+    }
+
+    // one buffer for all lines, it only grows for lines longer
+    // than the buffer, complete lines are handed out in place
+    QByteArray buffer(65536, Qt::Uninitialized);
+    int filled = 0;
+    int lines = 0;
+    bool stopped = false;
+
+    while (!stopped)
+    {
+        if (filled == buffer.size())
+            buffer.resize(buffer.size() * 2);
+
+        ssize_t len = read(fd[0], buffer.data() + filled, buffer.size() - filled);
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len <= 0)
+            break;
+
+        const char* data = buffer.constData();
+        int start = 0;
+        int end = filled + len;
+        const char* nl = static_cast<const char*>(memchr(data + filled, '\n', len));
+
+        while (nl && !stopped)
+        {
+            int next = nl - data + 1;
+
+            lines++;
+            stopped = !_lineHandler(QByteArray::fromRawData(data + start, next - start));
+            start = next;
+            nl = static_cast<const char*>(memchr(data + start, '\n', end - start));
+        }
+
+        // keep the incomplete last line
+        filled = end - start;
+        if (start && filled)
+            memmove(buffer.data(), buffer.constData() + start, filled);
+    }
+
+    // last line without newline
+    if (!stopped && filled)
+    {
+        lines++;
+        _lineHandler(QByteArray::fromRawData(buffer.constData(), filled));
+    }
+
+    close(fd[0]);
+
+    if (stopped)
+        kill(pid, SIGTERM);
+
+    int status = waitForExit(pid);
+
+    if (_log)
+        std::cout << "  " << lines << " lines, " << timer.elapsed() << " ms" << std::endl;
+
+    return stopped ? 0 : status;
+}
+
+int execute_cmd(const QStringList& _argv, QList<QString>& _output, bool _log)
+{
+    return execute_cmd(_argv, QByteArray(), _output, _log);
+}
+
+int execute_cmd(const QStringList& _argv, const QByteArray& _input, QList<QString>& _output, bool _log)
+{
+    return execute_cmd(
+        _argv,
+        _input,
+        [&_output](const QByteArray& _line)
+        {
+            _output.push_back(QString::fromUtf8(_line));
+            return true;
+        },
+        _log);
+}
+
+int execute_cmd(const QStringList& _argv, const QString& _outputPath, bool _log)
 {
-    char buffer[65536];
+    QElapsedTimer timer;
+
+    timer.start();
+
+    if (_log)
+        std::cout << cmdLine(_argv).toUtf8().data() << " > " << _outputPath.toUtf8().data() << std::endl;
+
+    int fd = open(_outputPath.toLocal8Bit().data(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+
+    if (fd == -1)
+        return -1;
+
+    pid_t pid = spawn(_argv, fd);
+
+    close(fd);
+
+    if (pid == -1)
+    {
+        std::cerr << "Error: Could not run " << cmdLine(_argv).toUtf8().data() << std::endl;
+        return -1;
+    }
+
+    int status = waitForExit(pid);
 
     if (_log)
-        std::cout << _cmd << std::endl;
+        std::cout << "  " << timer.elapsed() << " ms" << std::endl;
+
+    return status;
+}
+
+// results of execute_cmds()
+struct CmdResults
+{
+    QMutex mutex;
+    QWaitCondition finished;
+    QVector<QList<QString> > output;
+    QVector<int> status;
+    QVector<bool> done;
+};
+
+class CmdRunnable : public QRunnable
+{
+public:
+    CmdRunnable(CmdResults* _results, int _index, const QStringList& _argv, bool _log) :
+        results(_results),
+        index(_index),
+        argv(_argv),
+        log(_log)
+    {
+    }
 
-    FILE* pipe = popen(_cmd, "r");
-    if (pipe)
+    virtual void run()
     {
-        while (fgets(buffer, 65536, pipe) != NULL)
+        QList<QString> output;
+        int status = execute_cmd(argv, output, log);
+
+        QMutexLocker lock(&results->mutex);
+
+        results->output[index].swap(output);
+        results->status[index] = status;
+        results->done[index] = true;
+        results->finished.wakeAll();
+    }
+
+private:
+    CmdResults* results;
+    int index;
+    QStringList argv;
+    bool log;
+};
+
+void execute_cmds(const QList<QStringList>& _argvs,
+                  const std::function<void(int, int, const QList<QString>&)>& _resultHandler,
+                  bool _log)
+{
+    CmdResults results;
+
+    results.output.resize(_argvs.size());
+    results.status.fill(-1, _argvs.size());
+    results.done.fill(false, _argvs.size());
+
+    // the commands mostly wait for git, one thread per core is enough
+    QThreadPool pool;
+
+    pool.setMaxThreadCount(qMax(1, qMin(QThread::idealThreadCount(), _argvs.size())));
+
+    for (int i = 0; i < _argvs.size(); i++)
+    {
+        pool.start(new CmdRunnable(&results, i, _argvs.at(i), _log));
+    }
+
+    for (int i = 0; i < _argvs.size(); i++)
+    {
+        QList<QString> output;
+        int status;
+
         {
-            _output.push_back(QString(buffer));
+            QMutexLocker lock(&results.mutex);
+
+            while (!results.done.at(i))
+                results.finished.wait(&results.mutex);
+
+            output.swap(results.output[i]);
+            status = results.status.at(i);
         }
-        pclose(pipe);
+
+        _resultHandler(i, status, output);
     }
+
+    pool.waitForDone();
+}
+
+pid_t execute_cmd_start(const QStringList& _argv, int& _stdinFd, int& _stdoutFd, bool _log)
+{
+    if (_log)
+        std::cout << cmdLine(_argv).toUtf8().data() << " &" << std::endl;
+
+    int in[2];
+    int out[2];
+
+    if (pipe2(in, O_CLOEXEC) != 0)
+        return -1;
+
+    if (pipe2(out, O_CLOEXEC) != 0)
+    {
+        close(in[0]);
+        close(in[1]);
+        return -1;
+    }
+
+    pid_t pid = spawn(_argv, out[1], in[0]);
+
+    close(in[0]);
+    close(out[1]);
+
+    if (pid == -1)
+    {
+        close(in[1]);
+        close(out[0]);
+        std::cerr << "Error: Could not run " << cmdLine(_argv).toUtf8().data() << std::endl;
+        return -1;
+    }
+
+    _stdinFd = in[1];
+    _stdoutFd = out[0];
+
+    return pid;
+}
+
+int execute_cmd_finish(pid_t _pid, int _stdinFd, int _stdoutFd)
+{
+    // closing stdin ends a co-process reading requests
+    close(_stdinFd);
+    close(_stdoutFd);
+
+    return waitForExit(_pid);
 }
@@ -18,9 +18,74 @@
 #ifndef __EXECUTE_CMD_H__
 #define __EXECUTE_CMD_H__
 
+#include <QByteArray>
 #include <QString>
+#include <QStringList>
 #include <QList>
 
-void execute_cmd(const char* _cmd, QList<QString>& _output, bool _log = false);
+#include <functional>
+#include <sys/types.h>
+
+/**
+ * \brief Run the program _argv[0] with the arguments _argv[1..] by
+ *        posix_spawnp, there is no shell in between, so arguments are
+ *        neither split nor quoted.
+ *        Each complete line of stdout (including the newline) is passed
+ *        to _lineHandler as soon as it has been read, lines are not
+ *        limited in length. The line refers to the read buffer and is
+ *        only valid during the call.
+ *        If _lineHandler returns false, reading stops and the command
+ *        is terminated.
+ *        If _log is set, the command and its run time are printed.
+ *
+ * \return exit status of the command, -1 if it could not be run
+ */
+int execute_cmd(const QStringList& _argv,
+                const std::function<bool(const QByteArray&)>& _lineHandler,
+                bool _log = false);
+
+/**
+ * \brief As above, _input is written to stdin of the command and stdin
+ *        is closed before stdout is read, so the command has to read
+ *        all of its input first, e.g. revisions for git --stdin.
+ *        A null _input keeps stdin of gvtree.
+ */
+int execute_cmd(const QStringList& _argv,
+                const QByteArray& _input,
+                const std::function<bool(const QByteArray&)>& _lineHandler,
+                bool _log = false);
+
+/**
+ * \brief Collect all lines of stdout in _output.
+ */
+int execute_cmd(const QStringList& _argv, QList<QString>& _output, bool _log = false);
+int execute_cmd(const QStringList& _argv, const QByteArray& _input, QList<QString>& _output, bool _log = false);
+
+/**
+ * \brief Write stdout to the file _outputPath.
+ */
+int execute_cmd(const QStringList& _argv, const QString& _outputPath, bool _log = false);
+
+/**
+ * \brief Run all commands _argvs concurrently on a pool of at most
+ *        QThread::idealThreadCount() threads. _resultHandler is called
+ *        in the calling thread with the index in _argvs, the exit status
+ *        and all lines of stdout. The calls are in the order of _argvs,
+ *        each one as soon as its command and all commands before have
+ *        finished.
+ */
+void execute_cmds(const QList<QStringList>& _argvs,
+                  const std::function<void(int, int, const QList<QString>&)>& _resultHandler,
+                  bool _log = false);
+
+/**
+ * \brief Start _argv as co-process, _stdinFd and _stdoutFd are the
+ *        parent ends of the pipes to its stdin and stdout.
+ *        execute_cmd_finish() closes both and waits for the process.
+ *
+ * \return process id, -1 if the command could not be started
+ */
+pid_t execute_cmd_start(const QStringList& _argv, int& _stdinFd, int& _stdoutFd, bool _log = false);
+int execute_cmd_finish(pid_t _pid, int _stdinFd, int _stdoutFd);
 
 #endif
@@ -0,0 +1,367 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QMutexLocker>
+
+#include "execute_cmd.h"
+#include "gitcatfile.h"
+
+// requests written ahead of the responses, they have to fit
+// into the pipe, otherwise both sides could block on write
+static const int maxQueueBytes = 16384;
+
+GitCatFile::CoProcess::CoProcess() :
+    pid(-1),
+    in(-1),
+    out(-1),
+    pos(0)
+{
+}
+
+bool GitCatFile::CoProcess::start(const QStringList& _argv, bool _log)
+{
+    stop();
+
+    pid = execute_cmd_start(_argv, in, out, _log);
+
+    return pid != -1;
+}
+
+void GitCatFile::CoProcess::stop()
+{
+    if (pid != -1)
+        execute_cmd_finish(pid, in, out);
+
+    pid = -1;
+    in = -1;
+    out = -1;
+    buffer.clear();
+    pos = 0;
+}
+
+bool GitCatFile::CoProcess::isRunning() const
+{
+    return pid != -1;
+}
+
+bool GitCatFile::CoProcess::write(const QByteArray& _data)
+{
+    // a died co-process must not terminate gvtree by SIGPIPE
+    sigset_t pipeSet;
+    sigset_t oldSet;
+
+    sigemptyset(&pipeSet);
+    sigaddset(&pipeSet, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &pipeSet, &oldSet);
+
+    const char* data = _data.constData();
+    qint64 left = _data.size();
+    bool ok = true;
+
+    while (left > 0)
+    {
+        ssize_t len = ::write(in, data, left);
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len <= 0)
+        {
+            ok = false;
+            break;
+        }
+
+        data += len;
+        left -= len;
+    }
+
+    if (!ok && errno == EPIPE)
+    {
+        struct timespec zero = {0, 0};
+
+        sigtimedwait(&pipeSet, NULL, &zero);
+    }
+
+    pthread_sigmask(SIG_SETMASK, &oldSet, NULL);
+
+    return ok;
+}
+
+bool GitCatFile::CoProcess::fill()
+{
+    // drop consumed data
+    if (pos > 0)
+    {
+        buffer.remove(0, pos);
+        pos = 0;
+    }
+
+    char tmp[65536];
+
+    for (;;)
+    {
+        ssize_t len = ::read(out, tmp, sizeof(tmp));
+
+        if (len < 0 && errno == EINTR)
+            continue;
+
+        if (len <= 0)
+            return false;
+
+        buffer.append(tmp, len);
+        return true;
+    }
+}
+
+bool GitCatFile::CoProcess::readLine(QByteArray& _line)
+{
+    int nl;
+
+    while ((nl = buffer.indexOf('\n', pos)) == -1)
+    {
+        if (!fill())
+            return false;
+    }
+
+    _line = buffer.mid(pos, nl - pos);
+    pos = nl + 1;
+
+    return true;
+}
+
+bool GitCatFile::CoProcess::readBytes(qint64 _size, QByteArray& _data)
+{
+    while (buffer.size() - pos < _size)
+    {
+        if (!fill())
+            return false;
+    }
+
+    _data = buffer.mid(pos, _size);
+    pos += _size;
+
+    return true;
+}
+
+GitCatFile::GitCatFile() :
+    log(false)
+{
+}
+
+GitCatFile::~GitCatFile()
+{
+    batch.stop();
+    batchCheck.stop();
+}
+
+void GitCatFile::setRepositoryPath(const QString& _path, bool _log)
+{
+    QMutexLocker lock(&mutex);
+
+    log = _log;
+
+    if (repositoryPath == _path)
+        return;
+
+    batch.stop();
+    batchCheck.stop();
+    repositoryPath = _path;
+}
+
+bool GitCatFile::query(CoProcess& _process,
+                       const QString& _mode,
+                       const QStringList& _names,
+                       const std::function<void(int, const QByteArray&, const QByteArray&)>& _handler)
+{
+    if (repositoryPath.isEmpty())
+        return false;
+
+    if (!_process.isRunning()
+        && !_process.start(QStringList() << "git" << "-C" << repositoryPath << "cat-file" << _mode, log))
+        return false;
+
+    bool contents = (_mode == "--batch");
+    int first = 0;
+
+    while (first < _names.size())
+    {
+        // queue as many requests as fit into the pipe
+        QByteArray requests;
+        int last = first;
+
+        while (last < _names.size()
+               && (last == first || requests.size() + _names.at(last).size() < maxQueueBytes))
+        {
+            QByteArray name = _names.at(last).toUtf8();
+
+            // a newline would split the request, such an object does not exist
+            if (name.contains('\n'))
+                name = "\t";
+
+            requests += name + "\n";
+            last++;
+        }
+
+        if (!_process.write(requests))
+        {
+            _process.stop();
+            return false;
+        }
+
+        for (int i = first; i < last; i++)
+        {
+            QByteArray header;
+            QByteArray content;
+
+            if (!_process.readLine(header))
+            {
+                _process.stop();
+                return false;
+            }
+
+            // "<oid> <type> <size>" or "<name> missing"
+            QList<QByteArray> fields = header.split(' ');
+
+            if (fields.size() != 3 || header.endsWith(" missing") || header.endsWith(" ambiguous"))
+            {
+                _handler(i, QByteArray(), QByteArray());
+                continue;
+            }
+
+            if (contents)
+            {
+                QByteArray newline;
+
+                if (!_process.readBytes(fields.at(2).toLongLong(), content)
+                    || !_process.readBytes(1, newline))
+                {
+                    _process.stop();
+                    return false;
+                }
+            }
+
+            _handler(i, header, content);
+        }
+
+        first = last;
+    }
+
+    return true;
+}
+
+bool GitCatFile::read(const QStringList& _names,
+                      const std::function<void(int, const QByteArray&, const QByteArray&)>& _handler)
+{
+    QMutexLocker lock(&mutex);
+
+    return query(
+        batch,
+        "--batch",
+        _names,
+        [&_handler](int _index, const QByteArray& _header, const QByteArray& _content)
+        {
+            _handler(_index, _header.isEmpty() ? QByteArray() : _header.split(' ').at(1), _content);
+        });
+}
+
+bool GitCatFile::readObjects(const QStringList& _names,
+                             const std::function<void(int, const QByteArray&, const QByteArray&, const QByteArray&)>& _handler)
+{
+    QMutexLocker lock(&mutex);
+
+    return query(
+        batch,
+        "--batch",
+        _names,
+        [&_handler](int _index, const QByteArray& _header, const QByteArray& _content)
+        {
+            if (_header.isEmpty())
+            {
+                _handler(_index, QByteArray(), QByteArray(), QByteArray());
+                return;
+            }
+
+            QList<QByteArray> fields = _header.split(' ');
+
+            _handler(_index, fields.at(0), fields.at(1), _content);
+        });
+}
+
+bool GitCatFile::read(const QString& _name, QByteArray& _content, QByteArray* _type)
+{
+    bool found = false;
+
+    read(QStringList(_name),
+         [&found, &_content, _type](int, const QByteArray& _objectType, const QByteArray& _data)
+         {
+             found = !_objectType.isEmpty();
+             _content = _data;
+             if (_type)
+                 *_type = _objectType;
+         });
+
+    return found;
+}
+
+bool GitCatFile::readToFile(const QString& _name, const QString& _path)
+{
+    QByteArray content;
+    bool found = read(_name, content);
+
+    QFile file(_path);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    file.write(content);
+    file.close();
+
+    return found;
+}
+
+bool GitCatFile::info(const QString& _name, QByteArray& _oid, QByteArray& _type, qint64& _size)
+{
+    QMutexLocker lock(&mutex);
+
+    bool found = false;
+
+    query(batchCheck,
+          "--batch-check",
+          QStringList(_name),
+          [&](int, const QByteArray& _header, const QByteArray&)
+          {
+              if (_header.isEmpty())
+                  return;
+
+              QList<QByteArray> fields = _header.split(' ');
+
+              _oid = fields.at(0);
+              _type = fields.at(1);
+              _size = fields.at(2).toLongLong();
+              found = true;
+          });
+
+    return found;
+}
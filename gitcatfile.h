@@ -0,0 +1,121 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __GITCATFILE_H__
+#define __GITCATFILE_H__
+
+#include <QByteArray>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+#include <functional>
+#include <sys/types.h>
+
+/**
+ * \brief Long-lived git cat-file --batch and --batch-check co-processes
+ *        of one repository. Object reads are pipe round trips instead of
+ *        process launches. Requests of several objects are queued and
+ *        written ahead of the responses.
+ *        The co-processes are started on the first request and restarted
+ *        when the repository changes or a co-process has died.
+ *        All requests are serialized, GitCatFile can be used from
+ *        any thread.
+ */
+class GitCatFile
+{
+public:
+    GitCatFile();
+    ~GitCatFile();
+
+    void setRepositoryPath(const QString& _path, bool _log = false);
+
+    /**
+     * \brief Read the object _name, e.g. "<hash>" or "<hash>:<path>".
+     *
+     * \return false, if the object does not exist
+     */
+    bool read(const QString& _name, QByteArray& _content, QByteArray* _type = NULL);
+
+    /**
+     * \brief Read the object _name and write it to the file _path.
+     *        The file is created in any case.
+     */
+    bool readToFile(const QString& _name, const QString& _path);
+
+    /**
+     * \brief Read all objects _names. _handler gets the index in _names,
+     *        the object type and the content, an empty type for
+     *        missing objects.
+     */
+    bool read(const QStringList& _names,
+              const std::function<void(int, const QByteArray&, const QByteArray&)>& _handler);
+
+    /**
+     * \brief Like read() of several objects, _handler gets the index in
+     *        _names, the object id, the type and the content.
+     */
+    bool readObjects(const QStringList& _names,
+                     const std::function<void(int, const QByteArray&, const QByteArray&, const QByteArray&)>& _handler);
+
+    /**
+     * \brief Object id, type and size of _name without its content.
+     *
+     * \return false, if the object does not exist
+     */
+    bool info(const QString& _name, QByteArray& _oid, QByteArray& _type, qint64& _size);
+
+private:
+    struct CoProcess
+    {
+        CoProcess();
+
+        bool start(const QStringList& _argv, bool _log);
+        void stop();
+        bool isRunning() const;
+
+        bool write(const QByteArray& _data);
+        bool readLine(QByteArray& _line);
+        bool readBytes(qint64 _size, QByteArray& _data);
+
+        pid_t pid;
+        int in;
+        int out;
+
+        // read ahead buffer
+        QByteArray buffer;
+        int pos;
+
+    private:
+        bool fill();
+    };
+
+    // send _names in chunks and pass each response to _handler
+    bool query(CoProcess& _process,
+               const QString& _mode,
+               const QStringList& _names,
+               const std::function<void(int, const QByteArray&, const QByteArray&)>& _handler);
+
+    QMutex mutex;
+    QString repositoryPath;
+    bool log;
+
+    CoProcess batch;
+    CoProcess batchCheck;
+};
+
+#endif
@@ -0,0 +1,619 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <QSet>
+
+#include "commitgraph.h"
+#include "commitstore.h"
+#include "execute_cmd.h"
+#include "gitcatfile.h"
+#include "gitlogworker.h"
+#include "graphparser.h"
+#include "graphsnapshot.h"
+#include "graphwidget.h"
+#include "version.h"
+
+GitLogWorker::GitLogWorker(GraphWidget* _graph,
+                           const QStringList& _cmd,
+                           const QStringList& _commitGraphCmd,
+                           const QStringList& _parentsCmd,
+                           const QStringList& _tipsCmd,
+                           const QString& _repositoryPath,
+                           int _maxLines,
+                           int _sort,
+                           bool _log,
+                           const QStringList& _globalVersionInfo,
+                           const QStringList& _changeableVersionInfo,
+                           CommitStore* _store,
+                           const TagRules& _tagRules) :
+    QThread(_graph),
+    graph(_graph),
+    cmd(_cmd),
+    commitGraphCmd(_commitGraphCmd),
+    parentsCmd(_parentsCmd),
+    tipsCmd(_tipsCmd),
+    repositoryPath(_repositoryPath),
+    maxLines(_maxLines),
+    sort(_sort),
+    log(_log),
+    previewLines(0),
+    globalVersionInfo(_globalVersionInfo),
+    changeableVersionInfo(_changeableVersionInfo),
+    commitStore(_store),
+    tagRules(_tagRules),
+    complete(false),
+    lines(0),
+    rootVersion(NULL),
+    headVersion(NULL),
+    previewLinesRead(0),
+    previewRootVersion(NULL),
+    previewHeadVersion(NULL),
+    previewStore(NULL)
+{
+}
+
+GitLogWorker::~GitLogWorker()
+{
+    discard();
+
+    // not taken
+    foreach(QGraphicsItem * it, previewItems)
+    {
+        delete (it);
+    }
+    delete (previewRootVersion);
+
+    // after the versions which refer to it
+    delete (commitStore);
+    delete (previewStore);
+}
+
+void GitLogWorker::discard()
+{
+    // not taken, the items are not part of any scene
+    foreach(QGraphicsItem * it, items)
+    {
+        delete (it);
+    }
+    items.clear();
+
+    delete (rootVersion);
+    rootVersion = NULL;
+    headVersion = NULL;
+}
+
+bool GitLogWorker::readLines(const QStringList& _cmd, GraphParser& _parser, int _expectedLines)
+{
+    bool parsed = true;
+
+    lines = 0;
+    previewBuffer.clear();
+
+    execute_cmd(
+        _cmd,
+        [this, &_parser, &parsed, _expectedLines](const QByteArray& _line)
+        {
+            if (isInterruptionRequested())
+                return false;
+
+            // parsed while git is still writing, only the
+            // first lines are kept for the preview
+            if (!_parser.append(_line))
+            {
+                parsed = false;
+                return false;
+            }
+
+            lines++;
+
+            if (lines <= previewLines)
+                previewBuffer.push_back(QByteArray(_line.constData(), _line.size()));
+
+            if (lines == previewLines)
+                createPreview(_parser);
+
+            if ((lines % 1000) == 0)
+                emit progress(lines, _expectedLines);
+
+            return lines <= maxLines;
+        },
+        log);
+
+    previewBuffer.clear();
+
+    if (isInterruptionRequested())
+        return false;
+
+    emit progress(lines, _expectedLines);
+
+    return parsed;
+}
+
+void GitLogWorker::createPreview(const GraphParser& _parser)
+{
+    // the preview is shown once, also if the load falls back
+    previewLines = 0;
+
+    previewRootVersion = new Version(graph);
+    previewStore = new CommitStore();
+
+    GraphParser* parser = _parser.create(previewRootVersion, previewStore);
+
+    foreach(const QByteArray& line, previewBuffer)
+    {
+        parser->append(line);
+    }
+    parser->finish(previewItems, previewHeadVersion);
+    delete (parser);
+
+    previewRootVersion->collectFolderVersions(previewRootVersion, NULL);
+    GraphWidget::layoutTree(previewRootVersion, sort);
+
+    previewLinesRead = previewBuffer.size();
+    previewBuffer.clear();
+
+    emit previewReady();
+}
+
+bool GitLogWorker::loadCommitGraph()
+{
+    if (commitGraphCmd.isEmpty())
+        return false;
+
+    CommitGraph commitGraph;
+
+    if (!commitGraph.open(repositoryPath))
+        return false;
+
+    rootVersion = new Version(graph);
+
+    CommitGraphLineParser parser(graph, globalVersionInfo, changeableVersionInfo, rootVersion, commitStore, tagRules, commitGraph);
+
+    // commits newer than the commit-graph are not contained
+    // the commit-graph may contain commits of other refs, too
+    if (!readLines(commitGraphCmd, parser, qMin(commitGraph.size(), maxLines + 1)))
+    {
+        discard();
+        return false;
+    }
+
+    parser.finish(items, headVersion);
+
+    return true;
+}
+
+bool GitLogWorker::loadParents()
+{
+    if (parentsCmd.isEmpty())
+        return false;
+
+    rootVersion = new Version(graph);
+
+    ParentLineParser parser(graph, globalVersionInfo, changeableVersionInfo, rootVersion, commitStore, tagRules);
+
+    if (!readLines(parentsCmd, parser, maxLines + 1))
+    {
+        discard();
+        return false;
+    }
+
+    parser.finish(items, headVersion);
+
+    return true;
+}
+
+bool GitLogWorker::loadGraph()
+{
+    rootVersion = new Version(graph);
+
+    GraphLineParser parser(graph, globalVersionInfo, changeableVersionInfo, rootVersion, commitStore, tagRules);
+
+    // the lines up to a line which can not be parsed are used
+    if (!readLines(cmd, parser, maxLines + 1) && isInterruptionRequested())
+    {
+        discard();
+        return false;
+    }
+
+    parser.finish(items, headVersion);
+
+    return true;
+}
+
+void GitLogWorker::run()
+{
+    // before git log, so all tips are part of the loaded graph
+    if (tipsCmd.isEmpty() == false)
+    {
+        QList<QString> cache;
+
+        execute_cmd(tipsCmd, cache, log);
+        foreach (const QString& it, cache)
+        {
+            refTips.push_back(it.trimmed());
+        }
+    }
+
+    if (!loadCommitGraph())
+    {
+        if (isInterruptionRequested())
+            return;
+
+        if (!loadParents())
+        {
+            if (isInterruptionRequested() || !loadGraph())
+                return;
+        }
+    }
+
+    if (isInterruptionRequested())
+        return;
+
+    compactCommitStore();
+
+    rootVersion->collectFolderVersions(rootVersion, NULL);
+    GraphWidget::layoutTree(rootVersion, sort);
+
+    // the snapshot needs the ref tips to be checked at the next start
+    if (snapshotKey.isEmpty() == false && refTips.isEmpty() == false)
+        GraphSnapshot::save(snapshotKey, refTips, lines, rootVersion, headVersion, items);
+
+    complete = true;
+}
+
+void GitLogWorker::compactCommitStore()
+{
+    QList<Version*> versions;
+
+    foreach (QGraphicsItem * it, items)
+    {
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
+
+        Version* v = dynamic_cast<Version*>(it);
+
+        if (v && v->getCommitStoreRow() >= 0)
+            versions.push_back(v);
+    }
+
+    // all rows are in use, e.g. for a new store
+    if (versions.size() == commitStore->size())
+        return;
+
+    CommitStore* store = new CommitStore();
+
+    foreach (Version * v, versions)
+    {
+        v->setCommitStoreRow(store, store->copyRow(*commitStore, v->getCommitStoreRow()));
+    }
+
+    delete (commitStore);
+    commitStore = store;
+}
+
+bool GitLogWorker::takeResult(Version*& _rootVersion, QList<QGraphicsItem*>& _items, Version*& _headVersion, CommitStore*& _store)
+{
+    if (!complete || isInterruptionRequested())
+        return false;
+
+    _rootVersion = rootVersion;
+    _items = items;
+    _headVersion = headVersion;
+    _store = commitStore;
+
+    rootVersion = NULL;
+    commitStore = NULL;
+    headVersion = NULL;
+    items.clear();
+    complete = false;
+
+    return true;
+}
+
+bool GitLogWorker::takePreview(Version*& _rootVersion, QList<QGraphicsItem*>& _items, Version*& _headVersion, CommitStore*& _store)
+{
+    if (previewRootVersion == NULL || isInterruptionRequested())
+        return false;
+
+    _rootVersion = previewRootVersion;
+    _items = previewItems;
+    _headVersion = previewHeadVersion;
+    _store = previewStore;
+
+    previewRootVersion = NULL;
+    previewHeadVersion = NULL;
+    previewStore = NULL;
+    previewItems.clear();
+
+    return true;
+}
+
+int GitLogWorker::getPreviewLines() const
+{
+    return previewLinesRead;
+}
+
+void GitLogWorker::setPreviewLines(int _lines)
+{
+    previewLines = _lines;
+}
+
+int GitLogWorker::getLines() const
+{
+    return lines;
+}
+
+const QStringList& GitLogWorker::getRefTips() const
+{
+    return refTips;
+}
+
+void GitLogWorker::setSnapshotKey(const QString& _key)
+{
+    snapshotKey = _key;
+}
+
+GitRefreshWorker::GitRefreshWorker(const QString& _repositoryPath,
+                                   const QStringList& _revisions,
+                                   const QStringList& _refTips,
+                                   const QStringList& _decorated,
+                                   const QString& _format,
+                                   int _maxLines,
+                                   bool _log,
+                                   QObject* _parent) :
+    QThread(_parent),
+    git(QStringList() << "git" << "-C" << _repositoryPath),
+    revisions(_revisions),
+    baseRefTips(_refTips),
+    decorated(_decorated),
+    format(_format),
+    maxLines(_maxLines),
+    log(_log),
+    complete(false)
+{
+}
+
+void GitRefreshWorker::run()
+{
+    // current ref tips
+    QList<QString> cache;
+
+    execute_cmd(QStringList(git) << "log" << "--no-walk" << "--pretty=%H" << revisions, cache, log);
+    foreach (const QString& it, cache)
+    {
+        refTips.push_back(it.trimmed());
+    }
+
+    if (refTips.isEmpty() || isInterruptionRequested())
+        return;
+
+    // the loaded ref tips and decorated versions are passed by stdin,
+    // there may be too many of them for the command line
+    QByteArray baseInput;
+    QByteArray excludeInput;
+
+    foreach (const QString& it, baseRefTips)
+    {
+        baseInput += it.toLatin1() + '\n';
+        excludeInput += '^' + it.toLatin1() + '\n';
+    }
+
+    // versions which are not reachable any more, e.g. after a forced
+    // update or a deleted branch, require a reload
+    cache.clear();
+    execute_cmd(QStringList(git) << "rev-list" << "--count" << "--stdin" << "--not" << revisions, baseInput, cache, log);
+
+    if (cache.size() != 1 || cache.front().trimmed() != QString("0") || isInterruptionRequested())
+        return;
+
+    // new commits, newest first, with their full object id and
+    // parents in front of the usual version information
+    if (refTips != baseRefTips)
+    {
+        execute_cmd(
+            QStringList(git)
+            << "log" << "--topo-order"
+            << "--pretty=%H %P" + format
+            << revisions << "--stdin",
+            excludeInput,
+            [this](const QByteArray& _line)
+            {
+                lines.push_back(QString::fromUtf8(_line));
+
+                // more than a page, the paged load is faster
+                return lines.size() <= maxLines && !isInterruptionRequested();
+            },
+            log);
+    }
+
+    if (lines.size() > maxLines || isInterruptionRequested())
+        return;
+
+    // refs may have moved to or away from loaded versions
+    QByteArray decoratedInput;
+
+    foreach (const QString& it, decorated)
+    {
+        decoratedInput += it.toLatin1() + '\n';
+    }
+
+    execute_cmd(QStringList(git) << "log" << "--no-walk" << "--pretty=" + format << "--all" << "--stdin", decoratedInput, decorationLines, log);
+
+    complete = !isInterruptionRequested();
+}
+
+bool GitRefreshWorker::isComplete() const
+{
+    return complete;
+}
+
+const QStringList& GitRefreshWorker::getBaseRefTips() const
+{
+    return baseRefTips;
+}
+
+const QStringList& GitRefreshWorker::getRefTips() const
+{
+    return refTips;
+}
+
+const QList<QString>& GitRefreshWorker::getLines() const
+{
+    return lines;
+}
+
+const QList<QString>& GitRefreshWorker::getDecorationLines() const
+{
+    return decorationLines;
+}
+
+GitPageWorker::GitPageWorker(const QString& _repositoryPath,
+                             const QStringList& _loaded,
+                             const QStringList& _pendingParents,
+                             const QString& _format,
+                             int _maxLines,
+                             bool _log,
+                             QObject* _parent) :
+    QThread(_parent),
+    repositoryPath(_repositoryPath),
+    loaded(_loaded),
+    pendingParents(_pendingParents),
+    format(_format),
+    maxLines(_maxLines),
+    log(_log),
+    complete(false)
+{
+}
+
+void GitPageWorker::collectBoundary()
+{
+    // the loaded hashes may be abbreviated, the parents are not
+    QSet<QString> hashes;
+    QSet<int> lengths;
+
+    foreach(const QString& hash, loaded)
+    {
+        hashes.insert(hash);
+        lengths.insert(hash.size());
+    }
+
+    QSet<QString> pending;
+
+    // own reader, the one of the GraphWidget is not blocked
+    GitCatFile catFile;
+
+    catFile.setRepositoryPath(repositoryPath, log);
+    catFile.readObjects(
+        loaded,
+        [this, &hashes, &lengths, &pending](int _index, const QByteArray&, const QByteArray& _type, const QByteArray& _content)
+        {
+            if (_type != "commit" || isInterruptionRequested())
+                return;
+
+            // the parent lines follow the tree line
+            int pos = _content.indexOf('\n') + 1;
+            bool first = true;
+
+            while (pos > 0 && _content.mid(pos, 7) == "parent ")
+            {
+                int end = _content.indexOf('\n', pos);
+
+                if (end == -1)
+                    break;
+
+                QString parent = QString::fromLatin1(_content.mid(pos + 7, end - pos - 7));
+                bool isLoaded = false;
+
+                foreach(int length, lengths)
+                {
+                    if (hashes.contains(parent.left(length)))
+                    {
+                        isLoaded = true;
+                        break;
+                    }
+                }
+
+                if (!isLoaded)
+                {
+                    Boundary b;
+
+                    b.child = loaded.at(_index);
+                    b.parent = parent;
+                    b.firstParent = first;
+                    boundary.push_back(b);
+
+                    if (!pending.contains(parent))
+                    {
+                        pending.insert(parent);
+                        pendingParents.push_back(parent);
+                    }
+                }
+
+                first = false;
+                pos = end + 1;
+            }
+        });
+}
+
+void GitPageWorker::run()
+{
+    if (pendingParents.isEmpty())
+        collectBoundary();
+
+    if (isInterruptionRequested())
+        return;
+
+    // The loaded versions are the start of a topological order, so
+    // all versions which are not loaded are ancestors of the pending
+    // parents. The next page continues this order.
+    if (pendingParents.size())
+    {
+        // there may be too many for the command line
+        QByteArray input;
+
+        foreach(const QString& parent, pendingParents)
+        {
+            input += parent.toLatin1() + '\n';
+        }
+
+        execute_cmd(QStringList()
+                    << "git" << "-C" << repositoryPath
+                    << "log" << "--topo-order" << "-n" << QString::number(maxLines)
+                    << "--pretty=%H %P" + format
+                    << "--stdin",
+                    input,
+                    lines,
+                    log);
+    }
+
+    complete = !isInterruptionRequested();
+}
+
+bool GitPageWorker::isComplete() const
+{
+    return complete;
+}
+
+const QList<GitPageWorker::Boundary>& GitPageWorker::getBoundary() const
+{
+    return boundary;
+}
+
+const QList<QString>& GitPageWorker::getLines() const
+{
+    return lines;
+}
@@ -0,0 +1,286 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#ifndef __GITLOGWORKER_H__
+#define __GITLOGWORKER_H__
+
+#include <QThread>
+#include <QByteArray>
+#include <QGraphicsItem>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+#include "tagrules.h"
+
+class CommitStore;
+class GraphParser;
+class GraphWidget;
+class Version;
+
+/**
+ * \brief GitLogWorker runs git log, the graph parser and the
+ *        tree layout in a background thread. The topology is taken
+ *        from the commit-graph file, if it is missing or outdated
+ *        from the parent hashes of git log, the git log --graph
+ *        output is the last fallback.
+ *        The output of git log is parsed while git writes it, a
+ *        preview of the newest versions can be shown before the
+ *        load is complete.
+ *        With a snapshot key the result is also written as
+ *        GraphSnapshot. Versions and edges are
+ *        created without a scene. When the thread has finished the
+ *        GraphWidget takes them over with takeResult().
+ *        A load is cancelled with requestInterruption(), versions
+ *        and edges which have not been taken are deleted with the worker.
+ *        The worker is a child of the GraphWidget, which waits for it
+ *        when it is destroyed.
+ */
+class GitLogWorker : public QThread
+{
+    Q_OBJECT
+
+public:
+    GitLogWorker(GraphWidget* _graph,
+                 const QStringList& _cmd,
+                 const QStringList& _commitGraphCmd,
+                 const QStringList& _parentsCmd,
+                 const QStringList& _tipsCmd,
+                 const QString& _repositoryPath,
+                 int _maxLines,
+                 int _sort,
+                 bool _log,
+                 const QStringList& _globalVersionInfo,
+                 const QStringList& _changeableVersionInfo,
+                 CommitStore* _store,
+                 const TagRules& _tagRules);
+    virtual ~GitLogWorker();
+
+    /**
+     * \brief Hand over the root version, all created items and the
+     *        commit store which holds their information.
+     *
+     * \return false, if the load has been cancelled
+     */
+    bool takeResult(Version*& _rootVersion, QList<QGraphicsItem*>& _items, Version*& _headVersion, CommitStore*& _store);
+
+    int getLines() const;
+
+    // hashes of the ref tips read before git log has been started
+    const QStringList& getRefTips() const;
+
+    // write a GraphSnapshot of the loaded graph for _key
+    void setSnapshotKey(const QString& _key);
+
+    // show the first _lines versions while the rest is loaded,
+    // 0 for no preview
+    void setPreviewLines(int _lines);
+
+    /**
+     * \brief Hand over the preview graph of the newest versions,
+     *        after previewReady() has been emitted.
+     *
+     * \return false, if there is no preview
+     */
+    bool takePreview(Version*& _rootVersion, QList<QGraphicsItem*>& _items, Version*& _headVersion, CommitStore*& _store);
+
+    int getPreviewLines() const;
+
+signals:
+    // _expectedLines is an estimate, 0 if unknown
+    void progress(int _lines, int _expectedLines);
+    void previewReady();
+
+protected:
+    virtual void run();
+
+    // feed the command output to _parser while git writes it,
+    // false if interrupted or a line can not be parsed
+    bool readLines(const QStringList& _cmd, GraphParser& _parser, int _expectedLines);
+
+    // graph of the first lines, see setPreviewLines()
+    void createPreview(const GraphParser& _parser);
+
+    // create the versions from the commit-graph file, the parent
+    // hashes or git log --graph
+    bool loadCommitGraph();
+    bool loadParents();
+    bool loadGraph();
+
+    // delete versions and edges of a failed attempt
+    void discard();
+
+    // the store of the last load keeps the rows of commits which are
+    // gone, replace it by a store of the rows of the loaded versions
+    void compactCommitStore();
+
+private:
+    GraphWidget* graph;
+    QStringList cmd;
+    QStringList commitGraphCmd;
+    QStringList parentsCmd;
+    QStringList tipsCmd;
+    QString repositoryPath;
+    int maxLines;
+    int sort;
+    bool log;
+    QString snapshotKey;
+    int previewLines;
+
+    // the first lines until the preview is created
+    QList<QByteArray> previewBuffer;
+
+    // copies, the lists of the GraphWidget may change meanwhile
+    QStringList globalVersionInfo;
+    QStringList changeableVersionInfo;
+
+    // owned until taken, a copy of the GraphWidget store or an
+    // empty one, updated by the parser
+    CommitStore* commitStore;
+
+    // copy of the tag preferences, they are not read in the thread
+    TagRules tagRules;
+
+    // result
+    bool complete;
+    int lines;
+    QStringList refTips;
+    Version* rootVersion;
+    Version* headVersion;
+    QList<QGraphicsItem*> items;
+
+    // preview, owned until taken
+    int previewLinesRead;
+    Version* previewRootVersion;
+    Version* previewHeadVersion;
+    QList<QGraphicsItem*> previewItems;
+    CommitStore* previewStore;
+};
+
+/**
+ * \brief GitRefreshWorker reads in a background thread what has
+ *        changed since the last load: the current ref tips, the new
+ *        commits with their parents and the decorations of the
+ *        versions _decorated and of all refs. The GraphWidget applies
+ *        the result, see GraphWidget::gitlogIncremental().
+ *        The worker is a child of the GraphWidget, which waits for it
+ *        when it is destroyed.
+ */
+class GitRefreshWorker : public QThread
+{
+public:
+    GitRefreshWorker(const QString& _repositoryPath,
+                     const QStringList& _revisions,
+                     const QStringList& _refTips,
+                     const QStringList& _decorated,
+                     const QString& _format,
+                     int _maxLines,
+                     bool _log,
+                     QObject* _parent = NULL);
+
+    // false, if interrupted or the graph has to be reloaded
+    bool isComplete() const;
+
+    // ref tips the changes are relative to
+    const QStringList& getBaseRefTips() const;
+
+    const QStringList& getRefTips() const;
+
+    // "<oid> <parent oids>#hash#...", newest first
+    const QList<QString>& getLines() const;
+
+    // git log lines of the decorated versions and all refs
+    const QList<QString>& getDecorationLines() const;
+
+protected:
+    virtual void run();
+
+private:
+    QStringList git;
+    QStringList revisions;
+    QStringList baseRefTips;
+    QStringList decorated;
+    QString format;
+    int maxLines;
+    bool log;
+
+    // result
+    bool complete;
+    QStringList refTips;
+    QList<QString> lines;
+    QList<QString> decorationLines;
+};
+
+/**
+ * \brief GitPageWorker reads the next page of older versions in a
+ *        background thread, see GraphWidget::gitlogNextPage().
+ *        Without pending parents the parents of the loaded versions,
+ *        which are not loaded, are read from their commit objects
+ *        first, this is needed once after a load only.
+ *        The worker is a child of the GraphWidget, which waits for it
+ *        when it is destroyed.
+ */
+class GitPageWorker : public QThread
+{
+public:
+    // the loaded version child is waiting for parent
+    struct Boundary
+    {
+        QString child;
+        QString parent;
+        bool firstParent;
+    };
+
+    GitPageWorker(const QString& _repositoryPath,
+                  const QStringList& _loaded,
+                  const QStringList& _pendingParents,
+                  const QString& _format,
+                  int _maxLines,
+                  bool _log,
+                  QObject* _parent = NULL);
+
+    // false, if interrupted
+    bool isComplete() const;
+
+    // parents collected for the loaded versions
+    const QList<Boundary>& getBoundary() const;
+
+    // "<oid> <parent oids>#hash#...", newest first
+    const QList<QString>& getLines() const;
+
+protected:
+    virtual void run();
+
+    // parents of the loaded versions which are not loaded
+    void collectBoundary();
+
+private:
+    QString repositoryPath;
+    QStringList loaded;
+    QStringList pendingParents;
+    QString format;
+    int maxLines;
+    bool log;
+
+    // result
+    bool complete;
+    QList<Boundary> boundary;
+    QList<QString> lines;
+};
+
+#endif
@@ -0,0 +1,193 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <iostream>
+
+#include <QIcon>
+
+#include "gitcatfile.h"
+#include "gittreemodel.h"
+
+using namespace std;
+
+// folder items: tree object id, path and load state
+static const int roleTreeOid = Qt::UserRole + 3;
+static const int roleTreePath = Qt::UserRole + 4;
+static const int roleTreeLoaded = Qt::UserRole + 5;
+
+QCache<QString, QList<GitTreeModel::Entry> > GitTreeModel::treeCache(1000000);
+
+GitTreeModel::GitTreeModel(GitCatFile* _catFile, QObject* _parent) :
+    QStandardItemModel(_parent),
+    catFile(_catFile)
+{
+}
+
+bool GitTreeModel::setVersion(const QString& _hash)
+{
+    QByteArray oid;
+    QByteArray type;
+    qint64 size;
+
+    if (!catFile->info(_hash + "^{tree}", oid, type, size))
+    {
+        cerr << "Error: No tree for " << _hash.toUtf8().data() << endl;
+        return false;
+    }
+
+    const QList<Entry>* entries = readTree(QString::fromLatin1(oid));
+
+    if (!entries)
+        return false;
+
+    appendEntries(invisibleRootItem(), QString(), *entries);
+
+    return true;
+}
+
+QStandardItem* GitTreeModel::pendingFolder(const QModelIndex& _index) const
+{
+    if (!_index.isValid())
+        return NULL;
+
+    QStandardItem* item = itemFromIndex(_index.sibling(_index.row(), 0));
+
+    if (!item
+        || item->data(roleTreeOid).toString().isEmpty()
+        || item->data(roleTreeLoaded).toBool())
+        return NULL;
+
+    return item;
+}
+
+bool GitTreeModel::hasChildren(const QModelIndex& _parent) const
+{
+    // show the expand indicator before the folder is loaded
+    if (pendingFolder(_parent))
+        return true;
+
+    return QStandardItemModel::hasChildren(_parent);
+}
+
+bool GitTreeModel::canFetchMore(const QModelIndex& _parent) const
+{
+    return pendingFolder(_parent) != NULL;
+}
+
+void GitTreeModel::fetchMore(const QModelIndex& _parent)
+{
+    QStandardItem* item = pendingFolder(_parent);
+
+    if (!item)
+        return;
+
+    item->setData(true, roleTreeLoaded);
+
+    const QList<Entry>* entries = readTree(item->data(roleTreeOid).toString());
+
+    if (entries)
+        appendEntries(item, item->data(roleTreePath).toString() + "/", *entries);
+}
+
+const QList<GitTreeModel::Entry>* GitTreeModel::readTree(const QString& _oid)
+{
+    QList<Entry>* entries = treeCache.object(_oid);
+
+    if (entries)
+        return entries;
+
+    QByteArray content;
+    QByteArray type;
+
+    if (!catFile->read(_oid, content, &type) || type != "tree")
+    {
+        cerr << "Error: Could not read tree " << _oid.toUtf8().data() << endl;
+        return NULL;
+    }
+
+    // "<mode> <name>\0<binary object id>" per entry,
+    // the object id has the length of the tree id
+    int oidLength = _oid.size() / 2;
+    const char* data = content.constData();
+    int pos = 0;
+
+    entries = new QList<Entry>;
+
+    while (pos < content.size())
+    {
+        int space = content.indexOf(' ', pos);
+        int end = (space == -1) ? -1 : content.indexOf('\0', space);
+
+        if (end == -1 || end + 1 + oidLength > content.size())
+        {
+            cerr << "Error: Invalid tree " << _oid.toUtf8().data() << endl;
+            break;
+        }
+
+        Entry entry;
+
+        // sub trees have the mode 40000
+        entry.tree = (content.mid(pos, space - pos) == "40000");
+        entry.name = QString::fromUtf8(data + space + 1, end - space - 1);
+        entry.oid = QString::fromLatin1(QByteArray(data + end + 1, oidLength).toHex());
+        entries->push_back(entry);
+
+        pos = end + 1 + oidLength;
+    }
+
+    const QList<Entry>* result = entries;
+
+    treeCache.insert(_oid, entries, qMax(1, entries->size()));
+
+    // too large for the cache, it has been deleted
+    if (!treeCache.contains(_oid))
+        return NULL;
+
+    return result;
+}
+
+void GitTreeModel::appendEntries(QStandardItem* _parent, const QString& _path, const QList<Entry>& _entries)
+{
+    foreach(const Entry& entry, _entries)
+    {
+        QString path = _path + entry.name;
+        QStandardItem* t = new QStandardItem(entry.name);
+
+        t->setEditable(false);
+
+        if (entry.tree)
+        {
+            t->setIcon(QIcon().fromTheme("folder")); // folder-open
+            t->setData(entry.oid, roleTreeOid);
+            t->setData(path, roleTreePath);
+            t->setData(false, roleTreeLoaded);
+            _parent->appendRow(t);
+        }
+        else
+        {
+            QList<QStandardItem*> columns;
+
+            columns << t;
+            QStandardItem* actitem = new QStandardItem(path);
+            actitem->setEditable(false);
+            actitem->setData("X", Qt::UserRole + 1);
+            actitem->setData(path, Qt::UserRole + 2);
+            columns << actitem;
+            _parent->appendRow(columns);
+        }
+    }
+}
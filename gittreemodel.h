@@ -0,0 +1,71 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __GITTREEMODEL_H__
+#define __GITTREEMODEL_H__
+
+#include <QCache>
+#include <QList>
+#include <QStandardItemModel>
+#include <QString>
+
+class GitCatFile;
+
+/**
+ * \brief File tree of one git version for the CompareTree.
+ *        Only the top level is listed at first, the entries of a
+ *        folder are read from its tree object when the folder is
+ *        expanded. The items are the same as those created for the
+ *        complete tree: name, and for files the path with status "X".
+ *        Parsed tree objects are cached by their object id, so
+ *        unchanged folders of other versions are not read again.
+ */
+class GitTreeModel : public QStandardItemModel
+{
+public:
+    GitTreeModel(GitCatFile* _catFile, QObject* _parent = NULL);
+
+    // list the top level of the version _hash
+    bool setVersion(const QString& _hash);
+
+    virtual bool hasChildren(const QModelIndex& _parent = QModelIndex()) const;
+    virtual bool canFetchMore(const QModelIndex& _parent) const;
+    virtual void fetchMore(const QModelIndex& _parent);
+
+protected:
+    struct Entry
+    {
+        QString name;
+        QString oid;
+        bool tree;
+    };
+
+    // folder item of _index, NULL for files and loaded folders
+    QStandardItem* pendingFolder(const QModelIndex& _index) const;
+
+    // entries of the tree object _oid
+    const QList<Entry>* readTree(const QString& _oid);
+    void appendEntries(QStandardItem* _parent, const QString& _path, const QList<Entry>& _entries);
+
+private:
+    GitCatFile* catFile;
+
+    // tree object id to entries, the cost is the number of entries
+    static QCache<QString, QList<Entry> > treeCache;
+};
+
+#endif
@@ -0,0 +1,114 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <string.h>
+
+#include "graphlinescanner.h"
+
+static inline bool isGraphCharacter(char _c)
+{
+    switch (_c)
+    {
+    case '*':
+    case '\\':
+    case '/':
+    case '.':
+    case '|':
+    case '-':
+    case '_':
+    case ' ':
+        return true;
+    }
+    return false;
+}
+
+bool GraphLineScanner::scan(const char* _data, int _size)
+{
+    fields.clear();
+
+    // same as the former pattern ^([*\\/\. |\-_]*[*\\/\.|\-_]+)
+    int end = 0;
+    int len = 0;
+
+    while (end < _size && isGraphCharacter(_data[end]))
+    {
+        if (_data[end] != ' ')
+            len = end + 1;
+        end++;
+    }
+
+    if (len == 0)
+    {
+        tree = View();
+        info = View();
+        return false;
+    }
+
+    tree = View(_data, len);
+    info = View(_data + len, _size - len);
+
+    const char* pos = info.data;
+    const char* last = info.data + info.size;
+
+    for (;;)
+    {
+        const char* sep = static_cast<const char*>(memchr(pos, '#', last - pos));
+
+        if (!sep)
+        {
+            fields.append(View(pos, int(last - pos)));
+            break;
+        }
+
+        fields.append(View(pos, int(sep - pos)));
+        pos = sep + 1;
+    }
+
+    return true;
+}
+
+const GraphLineScanner::View& GraphLineScanner::getTree() const
+{
+    return tree;
+}
+
+const GraphLineScanner::View& GraphLineScanner::getInfo() const
+{
+    return info;
+}
+
+int GraphLineScanner::getFieldCount() const
+{
+    return fields.size();
+}
+
+const GraphLineScanner::View& GraphLineScanner::getField(int _index) const
+{
+    return fields.at(_index);
+}
+
+QStringList GraphLineScanner::getFieldStrings() const
+{
+    QStringList result;
+
+    for (int i = 0; i < fields.size(); i++)
+    {
+        result.push_back(fields.at(i).toString());
+    }
+
+    return result;
+}
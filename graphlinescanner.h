@@ -0,0 +1,75 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __GRAPHLINESCANNER_H__
+#define __GRAPHLINESCANNER_H__
+
+#include <QString>
+#include <QStringList>
+#include <QVarLengthArray>
+
+/**
+ * \brief Scanner of one UTF-8 line of git log --graph output in a
+ *        single pass: the graph prefix, e.g. "| * ", and the '#'
+ *        separated fields of the version information behind it.
+ *        The results are views into the scanned line, nothing is
+ *        copied, they are valid as long as the line is.
+ */
+class GraphLineScanner
+{
+public:
+    struct View
+    {
+        View() : data(NULL), size(0) {}
+        View(const char* _data, int _size) : data(_data), size(_size) {}
+
+        QString toString() const
+        {
+            return QString::fromUtf8(data, size);
+        }
+
+        const char* data;
+        int size;
+    };
+
+    /**
+     * \brief Scan _size bytes at _data. The graph prefix consists of
+     *        the characters "*\/.|-_ " and ends at the last one which
+     *        is not a blank.
+     *
+     * \return false, if the line does not start with a graph prefix
+     */
+    bool scan(const char* _data, int _size);
+
+    // graph prefix
+    const View& getTree() const;
+
+    // everything behind the graph prefix
+    const View& getInfo() const;
+
+    // the information split at '#'
+    int getFieldCount() const;
+    const View& getField(int _index) const;
+    QStringList getFieldStrings() const;
+
+private:
+    View tree;
+    View info;
+    QVarLengthArray<View, 16> fields;
+};
+
+#endif
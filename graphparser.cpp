@@ -0,0 +1,477 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#include <iostream>
+
+#include "commitgraph.h"
+#include "commitstore.h"
+#include "edge.h"
+#include "graphparser.h"
+#include "graphwidget.h"
+#include "version.h"
+
+using namespace std;
+
+GraphParser::GraphParser(GraphWidget* _graph,
+                         const QStringList& _globalVersionInfo,
+                         const QStringList& _changeableVersionInfo,
+                         Version* _root,
+                         CommitStore* _store,
+                         const TagRules& _rules) :
+    graph(_graph),
+    globalVersionInfo(_globalVersionInfo),
+    changeableVersionInfo(_changeableVersionInfo),
+    root(_root),
+    store(_store),
+    rules(_rules),
+    firstParentMain(true)
+{
+}
+
+GraphParser::~GraphParser()
+{
+    // not handed over by finish()
+    foreach(const Relation& r, relations)
+    {
+        delete (r.version);
+    }
+}
+
+Version* GraphParser::createVersion(const QStringList& _parts)
+{
+    // create version node
+    Version* v = new Version(globalVersionInfo, changeableVersionInfo, graph);
+
+    // init or update, information which has already been
+    // parsed is taken from the commit store
+    v->processGitLogInfo(store, rules, _parts);
+
+    //
+    v->setIsFoldable(rules.isFoldable(v->getInformationKeys()));
+    v->setIsMain(false);
+
+    Relation r;
+
+    r.version = v;
+    r.parent = NULL;
+    relations.push_back(r);
+
+    return v;
+}
+
+GraphParser::Slot GraphParser::parentSlot() const
+{
+    Slot s;
+
+    s.relation = relations.size() - 1;
+    s.merge = -1;
+
+    return s;
+}
+
+GraphParser::Slot GraphParser::mergeSlot()
+{
+    Slot s;
+
+    s.relation = relations.size() - 1;
+    s.merge = relations.last().merges.size();
+    relations.last().merges.push_back(NULL);
+
+    return s;
+}
+
+void GraphParser::resolve(const QVector<Slot>& _slots, Version* _version)
+{
+    foreach(const Slot& s, _slots)
+    {
+        Relation& r = relations[s.relation];
+
+        if (s.merge == -1)
+            r.parent = _version;
+        else
+            r.merges[s.merge] = _version;
+    }
+}
+
+void GraphParser::finish(QList<QGraphicsItem*>& _items, Version*& _headVersion)
+{
+    QHash<Version*, Version*> firstParents;
+
+    // root first, so the children of a version are
+    // in the same order as in git log --graph
+    for (int i = relations.size() - 1; i >= 0; i--)
+    {
+        const Relation& r = relations.at(i);
+
+        _items.push_back(r.version);
+
+        Edge* e = new Edge (r.parent ? r.parent : root, r.version, graph, false, r.parent == NULL);
+        _items.push_back(e);
+        firstParents.insert(r.version, r.parent);
+
+        foreach(Version * merge, r.merges)
+        {
+            if (merge == NULL || merge == r.parent)
+                continue;
+
+            Edge* mergeArrow = new Edge(merge, r.version, graph, true, false);
+
+            _items.push_back(mergeArrow);
+        }
+
+        // The first line contains the first version
+        // of the git log output.
+        _headVersion = r.version;
+    }
+
+    // handed over
+    relations.clear();
+
+    // main: first parent line of the head version
+    // like the first column of git log --graph
+    if (firstParentMain && firstParents.size())
+    {
+        for (Version* v = _headVersion; v != NULL; v = firstParents.value(v, NULL))
+        {
+            v->setIsMain(true);
+        }
+    }
+}
+
+GraphLineParser::GraphLineParser(GraphWidget* _graph,
+                                 const QStringList& _globalVersionInfo,
+                                 const QStringList& _changeableVersionInfo,
+                                 Version* _root,
+                                 CommitStore* _store,
+                                 const TagRules& _rules) :
+    GraphParser(_graph, _globalVersionInfo, _changeableVersionInfo, _root, _store, _rules),
+    lastStar(-1),
+    lineNumber(0)
+{
+    firstParentMain = false;
+}
+
+GraphParser* GraphLineParser::create(Version* _root, CommitStore* _store) const
+{
+    return new GraphLineParser(graph, globalVersionInfo, changeableVersionInfo, _root, _store, rules);
+}
+
+// character _i of _tree, 0 outside
+static inline char charAt(const GraphLineScanner::View& _tree, int _i)
+{
+    return (_i >= 0 && _i < _tree.size) ? _tree.data[_i] : 0;
+}
+
+bool GraphLineParser::append(const QByteArray& _line)
+{
+    // deep copy, the graph prefix of the last line refers to it
+    QByteArray line(_line.constData(), _line.size());
+
+    // get the tree pattern
+    if (!scanner.scan(line.constData(), line.size()))
+    {
+        cerr << "No --graph pattern contained in line " << lineNumber << " : " << line.constData() << endl;
+        return true;
+    }
+
+    // get --graph tree pattern
+    GraphLineScanner::View tree = scanner.getTree();
+
+    lineNumber++;
+
+    // the last line is complete now
+    link(tree);
+
+    lastLine = line;
+    lastTree = tree;
+    lastStar = -1;
+
+    // in each line at a maximum one new version '*' is contained
+    for (int i = 0; i < tree.size; i++)
+    {
+        if (tree.data[i] == '*')
+            lastStar = i;
+    }
+
+    if (lastStar == -1)
+        return true;
+
+    // abort, if too short...
+    if (scanner.getFieldCount() < 6)
+    {
+        cerr << "Error: Input too short " << line.constData() << endl;
+        lastStar = -1;
+        return false;
+    }
+
+    // behind the tree pattern the version information is contained
+    Version* v = createVersion(scanner.getFieldStrings());
+
+    // main?
+    v->setIsMain(lastStar == 0);
+
+    return true;
+}
+
+void GraphLineParser::link(const GraphLineScanner::View& _tree)
+{
+    // tree is the last line, previousTree the older line below it
+    const GraphLineScanner::View& tree = lastTree;
+    const GraphLineScanner::View& previousTree = _tree;
+
+    QVector<QVector<Slot> > previousWaiting(previousTree.size);
+
+    waiting.resize(tree.size);
+
+    if (lastStar != -1)
+    {
+        // the new version '*' of the last line has got
+        // one parent and n merge sources
+        int i = lastStar;
+        char cr = charAt(tree, i + 1);
+        char pl = charAt(previousTree, i - 1);
+        char pm = charAt(previousTree, i);
+        char pr = charAt(previousTree, i + 1);
+
+        if (pl == '/')
+            previousWaiting[i - 1].push_back(parentSlot());
+        else if (pm == '*' || pm == '|')
+            previousWaiting[i].push_back(parentSlot());
+        else if (pl == '\\' && i + 1 < previousTree.size)
+            previousWaiting[i + 1].push_back(parentSlot());
+
+        // collect merge sources, the parent itself is skipped by finish()
+        if (pm == '|' || pm == '*')
+            previousWaiting[i].push_back(mergeSlot());
+        if (pr == '\\')
+            previousWaiting[i + 1].push_back(mergeSlot());
+        if (cr == '-')
+        {
+            int j = i + 1;
+            while (j < tree.size && (tree.data[j] == '-' || tree.data[j] == '.'))
+            {
+                waiting[j].push_back(mergeSlot());
+                j++;
+            }
+        }
+    }
+
+    // The lane of each column continues in a column of the older
+    // line (>= 0) or in a column of the same line (-2 - column).
+    // The cases are the ones of the former root first parser.
+    const int none = -1;
+    QVector<int> lanes(tree.size, none);
+
+    for (int i = 0; i < tree.size; i++)
+    {
+        // current characters
+        // cll cl cm cr
+        // pll pl pm pr
+        char cll = charAt(tree, i - 2);
+        char cm = tree.data[i];
+        char pll = charAt(previousTree, i - 2);
+        char pl = charAt(previousTree, i - 1);
+        char pm = charAt(previousTree, i);
+        char pr = charAt(previousTree, i + 1);
+
+        // hope' all cases are covered
+        switch (cm)
+        {
+            case '|':
+                if (pm == '|' || pm == '*' || pm == '/' || pm == '\\')
+                    lanes[i] = i;
+                else if (pl == '/')
+                    lanes[i] = i - 1;
+                else if (pr == '\\')
+                    lanes[i] = i + 1;
+                break;
+            case '/':
+                if (cll == '_')
+                    lanes[i] = -2 - (i - 2);
+                else if (pll == '/')
+                    lanes[i] = i - 2;
+                else if (pl == '|' || pl == '*' || pl == '/')
+                    lanes[i] = i - 1;
+                else if (pm == '\\' || pm == '|')
+                    lanes[i] = i;
+                break;
+            case '_':
+                if (cll == '_')
+                    lanes[i] = -2 - (i - 2);
+                else if (pll == '/')
+                    lanes[i] = i - 2;
+                break;
+            case '\\':
+                if (pm == '/')
+                    lanes[i] = i;
+                else if (pr == '|' || pr == '*' || pr == '\\')
+                    lanes[i] = i + 1;
+                break;
+            case '.':
+            case '-':
+                if (pr == '\\' || pr == ' ')
+                    lanes[i] = i + 1;
+                break;
+            case '*':
+            case ' ':
+                break;
+            default:
+                // cannot happen, see GraphLineScanner
+                cerr << "Character " << cm << " not recognized." << endl;
+                break;
+        }
+    }
+
+    // right to left, a lane continued in the same line is
+    // handed on before that column is handed on itself
+    for (int i = tree.size - 1; i >= 0; i--)
+    {
+        int lane = lanes.at(i);
+
+        if (i == lastStar)
+            resolve(waiting.at(i), relations.last().version);
+        else if (lane >= 0)
+            previousWaiting[lane] += waiting.at(i);
+        else if (lane != none)
+            waiting[-2 - lane] += waiting.at(i);
+
+        // else the lane ends, the waiting versions are linked to the root
+    }
+
+    waiting = previousWaiting;
+}
+
+void GraphLineParser::finish(QList<QGraphicsItem*>& _items, Version*& _headVersion)
+{
+    // the oldest line has no line below it
+    link(GraphLineScanner::View());
+
+    lastLine.clear();
+    lastTree = GraphLineScanner::View();
+    lastStar = -1;
+
+    GraphParser::finish(_items, _headVersion);
+}
+
+ParentLineParser::ParentLineParser(GraphWidget* _graph,
+                                   const QStringList& _globalVersionInfo,
+                                   const QStringList& _changeableVersionInfo,
+                                   Version* _root,
+                                   CommitStore* _store,
+                                   const TagRules& _rules) :
+    GraphParser(_graph, _globalVersionInfo, _changeableVersionInfo, _root, _store, _rules)
+{
+}
+
+GraphParser* ParentLineParser::create(Version* _root, CommitStore* _store) const
+{
+    return new ParentLineParser(graph, globalVersionInfo, changeableVersionInfo, _root, _store, rules);
+}
+
+bool ParentLineParser::append(const QByteArray& _line)
+{
+    const char* data = _line.constData();
+    int sep = _line.indexOf('#');
+
+    // "<hash> <parent> <parent>...", all of the same size,
+    // 40 hex digits or 64 in a SHA-256 repository
+    int hashSize = _line.indexOf(' ');
+
+    if (hashSize == -1 || hashSize > sep)
+        hashSize = sep;
+
+    // same information as after the --graph pattern
+    QString info = (hashSize <= 0) ? QString() : QString::fromUtf8(data + sep, _line.size() - sep);
+
+    // tokenize
+    QStringList parts = info.split(QChar('#'));
+
+    // abort, if too short...
+    if (parts.size() < 6)
+    {
+        cerr << "Error: Input too short " << QByteArray(data, _line.size()).constData() << endl;
+        return false;
+    }
+
+    Version* v = createVersion(parts);
+
+    // the children parsed before are waiting for this version
+    resolve(pending.take(ObjectId(data, hashSize)), v);
+
+    // the first parent is the tree parent
+    for (int pos = hashSize + 1; pos + hashSize <= sep; pos += hashSize + 1)
+    {
+        pending[ObjectId(data + pos, hashSize)].push_back(pos == hashSize + 1 ? parentSlot() : mergeSlot());
+    }
+
+    return true;
+}
+
+CommitGraphLineParser::CommitGraphLineParser(GraphWidget* _graph,
+                                             const QStringList& _globalVersionInfo,
+                                             const QStringList& _changeableVersionInfo,
+                                             Version* _root,
+                                             CommitStore* _store,
+                                             const TagRules& _rules,
+                                             const CommitGraph& _commitGraph) :
+    GraphParser(_graph, _globalVersionInfo, _changeableVersionInfo, _root, _store, _rules),
+    commitGraph(_commitGraph)
+{
+}
+
+GraphParser* CommitGraphLineParser::create(Version* _root, CommitStore* _store) const
+{
+    return new CommitGraphLineParser(graph, globalVersionInfo, changeableVersionInfo, _root, _store, rules, commitGraph);
+}
+
+bool CommitGraphLineParser::append(const QByteArray& _line)
+{
+    const char* data = _line.constData();
+    int sep = _line.indexOf('#');
+
+    // commits newer than the commit-graph are not contained
+    int pos = (sep <= 0) ? -1 : commitGraph.lookup(data, sep);
+
+    if (pos == -1)
+        return false;
+
+    // same information as after the --graph pattern
+    QStringList parts = QString::fromUtf8(data + sep, _line.size() - sep).split(QChar('#'));
+
+    // abort, if too short...
+    if (parts.size() < 6)
+    {
+        cerr << "Error: Input too short " << QByteArray(data, _line.size()).constData() << endl;
+        return false;
+    }
+
+    Version* v = createVersion(parts);
+
+    // the children parsed before are waiting for this version
+    resolve(pending.take(pos), v);
+
+    // the first parent is the tree parent
+    commitGraph.getParents(pos, parents);
+
+    for (int j = 0; j < parents.size(); j++)
+    {
+        pending[parents.at(j)].push_back(j == 0 ? parentSlot() : mergeSlot());
+    }
+
+    return true;
+}
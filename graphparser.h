@@ -0,0 +1,209 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#ifndef __GRAPHPARSER_H__
+#define __GRAPHPARSER_H__
+
+#include <QByteArray>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "graphlinescanner.h"
+#include "objectid.h"
+#include "tagrules.h"
+
+class CommitGraph;
+class CommitStore;
+class GraphWidget;
+class Version;
+
+/**
+ * \brief GraphParser creates the versions below a root version
+ *        from git log output while git is still writing it. The
+ *        lines are appended newest first as git prints them, each
+ *        one is parsed at once and not kept. A version waits for
+ *        its parents until they are parsed, the edges are created
+ *        by finish(). Neither the scene nor any widget is touched,
+ *        so a GitLogWorker can parse in a background thread.
+ */
+class GraphParser
+{
+public:
+    GraphParser(GraphWidget* _graph,
+                const QStringList& _globalVersionInfo,
+                const QStringList& _changeableVersionInfo,
+                Version* _root,
+                CommitStore* _store,
+                const TagRules& _rules);
+    virtual ~GraphParser();
+
+    // parser of the same kind for the versions below _root
+    virtual GraphParser* create(Version* _root, CommitStore* _store) const = 0;
+
+    /**
+     * \brief Parse one line of git log output, _line may refer to a
+     *        read buffer, what is needed is copied.
+     *
+     * \return false, if the line can not be parsed
+     */
+    virtual bool append(const QByteArray& _line) = 0;
+
+    /**
+     * \brief Create the edges and hand over the versions and edges,
+     *        root first. Parents which have not been parsed are
+     *        skipped like in git log --graph, the version is linked
+     *        to the root instead.
+     */
+    virtual void finish(QList<QGraphicsItem*>& _items, Version*& _headVersion);
+
+protected:
+    // a parsed version and its parents, filled in when they are parsed
+    struct Relation
+    {
+        Version* version;
+        Version* parent;
+        QVector<Version*> merges;
+    };
+
+    // the parent (merge == -1) or a merge source of a relation
+    struct Slot
+    {
+        int relation;
+        int merge;
+    };
+
+    // new version from the '#' separated fields _parts
+    Version* createVersion(const QStringList& _parts);
+
+    // parent or next merge source of the last parsed version
+    Slot parentSlot() const;
+    Slot mergeSlot();
+
+    // _version is the parsed parent of the waiting _slots
+    void resolve(const QVector<Slot>& _slots, Version* _version);
+
+    GraphWidget* graph;
+    const QStringList& globalVersionInfo;
+    const QStringList& changeableVersionInfo;
+    Version* root;
+    CommitStore* store;
+    TagRules rules;
+
+    // newest first
+    QVector<Relation> relations;
+
+    // main is the first parent line of the head version,
+    // git log --graph marks its first column instead
+    bool firstParentMain;
+};
+
+/**
+ * \brief Parser of git log --graph output. The lanes of the graph
+ *        prefix lead from a version down to its parents, the versions
+ *        waiting on a lane are handed on from line to line until the
+ *        lane reaches the parent '*'.
+ */
+class GraphLineParser : public GraphParser
+{
+public:
+    GraphLineParser(GraphWidget* _graph,
+                    const QStringList& _globalVersionInfo,
+                    const QStringList& _changeableVersionInfo,
+                    Version* _root,
+                    CommitStore* _store,
+                    const TagRules& _rules);
+
+    virtual GraphParser* create(Version* _root, CommitStore* _store) const;
+    virtual bool append(const QByteArray& _line);
+    virtual void finish(QList<QGraphicsItem*>& _items, Version*& _headVersion);
+
+private:
+    // hand the versions waiting on the lanes of the last line on
+    // to the lanes of the older line with the graph prefix _tree
+    void link(const GraphLineScanner::View& _tree);
+
+    GraphLineScanner scanner;
+
+    // the last line, its graph prefix refers to it
+    QByteArray lastLine;
+    GraphLineScanner::View lastTree;
+
+    // column of the '*' of the last line or -1
+    int lastStar;
+
+    // versions waiting for the parent on each lane of the last line
+    QVector<QVector<Slot> > waiting;
+
+    int lineNumber;
+};
+
+/**
+ * \brief Parser of git log lines without --graph,
+ *        "<full hash> <full parent hashes>#<hash>#...".
+ */
+class ParentLineParser : public GraphParser
+{
+public:
+    ParentLineParser(GraphWidget* _graph,
+                     const QStringList& _globalVersionInfo,
+                     const QStringList& _changeableVersionInfo,
+                     Version* _root,
+                     CommitStore* _store,
+                     const TagRules& _rules);
+
+    virtual GraphParser* create(Version* _root, CommitStore* _store) const;
+    virtual bool append(const QByteArray& _line);
+
+private:
+    // versions waiting for the parent with the object id
+    QHash<ObjectId, QVector<Slot> > pending;
+};
+
+/**
+ * \brief Parser of git log lines "<full hash>#<hash>#...", the
+ *        parents are taken from the commit-graph file. A commit which
+ *        is not contained in an outdated commit-graph can not be parsed.
+ */
+class CommitGraphLineParser : public GraphParser
+{
+public:
+    CommitGraphLineParser(GraphWidget* _graph,
+                          const QStringList& _globalVersionInfo,
+                          const QStringList& _changeableVersionInfo,
+                          Version* _root,
+                          CommitStore* _store,
+                          const TagRules& _rules,
+                          const CommitGraph& _commitGraph);
+
+    virtual GraphParser* create(Version* _root, CommitStore* _store) const;
+    virtual bool append(const QByteArray& _line);
+
+private:
+    const CommitGraph& commitGraph;
+
+    // versions waiting for the parent at the commit-graph position
+    QHash<int, QVector<Slot> > pending;
+
+    QVector<int> parents;
+};
+
+#endif
@@ -0,0 +1,367 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <iostream>
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QStandardPaths>
+#else
+#include <QDesktopServices>
+#endif
+
+#include "commitstore.h"
+#include "edge.h"
+#include "graphsnapshot.h"
+#include "version.h"
+
+using namespace std;
+
+static const quint32 snapshotMagic = 0x47565453; // "GVTS"
+static const quint32 snapshotVersion = 2;
+
+GraphSnapshot::GraphSnapshot() :
+    lines(0),
+    headVersion(-1),
+    store(NULL)
+{
+}
+
+GraphSnapshot::~GraphSnapshot()
+{
+    delete (store);
+}
+
+quint64 GraphSnapshot::fingerprint(const QStringList& _refTips, int _lines, const QList<const Version*>& _versions)
+{
+    // FNV-1a, the fingerprints of the versions cover their information
+    quint64 value = 14695981039346656037ull;
+
+    foreach(const QString& tip, _refTips)
+    {
+        foreach(const QChar& c, tip)
+        {
+            value ^= c.unicode();
+            value *= 1099511628211ull;
+        }
+    }
+
+    value ^= quint64(_lines);
+    value *= 1099511628211ull;
+
+    foreach(const Version* v, _versions)
+    {
+        value ^= v->getCommitStore()->getFingerprint(v->getCommitStoreRow());
+        value *= 1099511628211ull;
+    }
+
+    return value ? value : 1;
+}
+
+quint64 GraphSnapshot::readFingerprint(const QString& _path, const QString& _key)
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return 0;
+
+    // only the header is read
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString key;
+    quint64 value = 0;
+
+    in >> magic >> version;
+
+    if (magic != snapshotMagic || version != snapshotVersion)
+        return 0;
+
+    in >> key >> value;
+
+    return (in.status() == QDataStream::Ok && key == _key) ? value : 0;
+}
+
+QString GraphSnapshot::cacheFileName(const QString& _kind, const QString& _key)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+    QString dir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+#else
+    QString dir = QDesktopServices::storageLocation(QDesktopServices::CacheLocation);
+#endif
+
+    if (dir.isEmpty())
+        return QString();
+
+    return dir + "/" + _kind + "/"
+           + QString::fromLatin1(QCryptographicHash::hash(_key.toUtf8(), QCryptographicHash::Sha1).toHex());
+}
+
+bool GraphSnapshot::save(const QString& _key,
+                         const QStringList& _refTips,
+                         int _lines,
+                         const Version* _root,
+                         const Version* _headVersion,
+                         const QList<QGraphicsItem*>& _items)
+{
+    QString path = cacheFileName("snapshots", _key);
+
+    if (path.isEmpty() || !QDir().mkpath(QFileInfo(path).path()))
+        return false;
+
+    QByteArray data;
+    QBuffer buffer(&data);
+
+    buffer.open(QIODevice::WriteOnly);
+
+    QDataStream out(&buffer);
+    QHash<const Node*, int> index;
+    QList<const Version*> versionItems;
+    QList<const Edge*> edgeItems;
+
+    index.insert(_root, -1);
+
+    foreach (const QGraphicsItem* it, _items)
+    {
+        if (it->type() == QGraphicsItem::UserType + 1)
+        {
+            const Version* v = dynamic_cast<const Version*>(it);
+
+            if (!v->getCommitStore())
+                return false;
+
+            index.insert(v, versionItems.size());
+            versionItems.push_back(v);
+        }
+        else if (it->type() == QGraphicsItem::UserType + 2)
+        {
+            edgeItems.push_back(dynamic_cast<const Edge*>(it));
+        }
+    }
+
+    // the same graph has been written before
+    quint64 value = fingerprint(_refTips, _lines, versionItems);
+
+    if (readFingerprint(path, _key) == value)
+        return true;
+
+    // only the rows of the versions, version i is row i
+    CommitStore versionStore;
+    QVector<float> x;
+    QVector<qint32> y;
+    QVector<quint8> flags;
+
+    foreach (const Version* v, versionItems)
+    {
+        if (versionStore.copyRow(*v->getCommitStore(), v->getCommitStoreRow()) != x.size())
+            return false;
+
+        x.push_back(v->getX());
+        y.push_back(v->getY());
+        flags.push_back((v->isMain() ? 1 : 0) | (v->isFoldable() ? 2 : 0));
+    }
+
+    QVector<qint32> sources;
+    QVector<qint32> dests;
+    QVector<quint8> edgeFlags;
+
+    foreach (const Edge* e, edgeItems)
+    {
+        sources.push_back(index.value(e->sourceVersion(), -1));
+        dests.push_back(index.value(e->destVersion(), -1));
+        edgeFlags.push_back((e->getMerge() ? 1 : 0) | (e->getInfo() ? 2 : 0));
+    }
+
+    out << snapshotMagic << snapshotVersion << _key << value << _refTips
+        << qint32(_lines) << qint32(index.value(_headVersion, -1));
+
+    versionStore.write(out);
+
+    out << x << y << flags << sources << dests << edgeFlags;
+
+    // replace the old snapshot at once, a concurrent reader
+    // sees either the old or the new file
+    QString tmpPath = path + "." + QString::number(getpid());
+    QFile file(tmpPath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || file.write(data) != data.size())
+    {
+        file.remove();
+        return false;
+    }
+    file.close();
+
+    if (rename(QFile::encodeName(tmpPath).data(), QFile::encodeName(path).data()) != 0)
+    {
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+bool GraphSnapshot::load(const QString& _key)
+{
+    QString path = cacheFileName("snapshots", _key);
+
+    if (path.isEmpty())
+        return false;
+
+    QFile file(path);
+
+    if (!file.open(QIODevice::ReadOnly) || file.size() == 0)
+        return false;
+
+    // the records are parsed from the mapped file, no copy is read
+    const uchar* map = file.map(0, file.size());
+
+    if (!map)
+        return false;
+
+    QByteArray data = QByteArray::fromRawData(reinterpret_cast<const char*>(map), file.size());
+    QDataStream in(data);
+
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString key;
+    qint32 numLines = 0;
+    qint32 head = -1;
+
+    in >> magic >> version;
+
+    if (magic != snapshotMagic || version != snapshotVersion)
+        return false;
+
+    // different key with the same file name
+    in >> key;
+
+    if (key != _key)
+        return false;
+
+    quint64 value = 0;
+
+    in >> value >> refTips >> numLines >> head;
+
+    CommitStore* versionStore = new CommitStore();
+    QVector<float> x;
+    QVector<qint32> y;
+    QVector<quint8> flags;
+    QVector<qint32> sources;
+    QVector<qint32> dests;
+    QVector<quint8> edgeFlags;
+
+    if (in.status() != QDataStream::Ok || !versionStore->read(in))
+    {
+        delete (versionStore);
+        return false;
+    }
+
+    in >> x >> y >> flags >> sources >> dests >> edgeFlags;
+
+    int count = versionStore->size();
+
+    if (in.status() != QDataStream::Ok || head < -1 || head >= count
+        || x.size() != count || y.size() != count || flags.size() != count
+        || dests.size() != sources.size() || edgeFlags.size() != sources.size())
+    {
+        cerr << "Error: Invalid graph snapshot " << path.toUtf8().data() << endl;
+        delete (versionStore);
+        return false;
+    }
+
+    versions.resize(count);
+
+    for (int i = 0; i < count; i++)
+    {
+        VersionRecord& r = versions[i];
+
+        r.x = x.at(i);
+        r.y = y.at(i);
+        r.main = flags.at(i) & 1;
+        r.foldable = flags.at(i) & 2;
+    }
+
+    edges.resize(sources.size());
+
+    for (int i = 0; i < sources.size(); i++)
+    {
+        EdgeRecord& r = edges[i];
+
+        // the root version has no in edge
+        if (sources.at(i) < -1 || sources.at(i) >= count || dests.at(i) < 0 || dests.at(i) >= count)
+        {
+            cerr << "Error: Invalid graph snapshot " << path.toUtf8().data() << endl;
+            delete (versionStore);
+            return false;
+        }
+
+        r.source = sources.at(i);
+        r.dest = dests.at(i);
+        r.merge = edgeFlags.at(i) & 1;
+        r.info = edgeFlags.at(i) & 2;
+    }
+
+    delete (store);
+    store = versionStore;
+    lines = numLines;
+    headVersion = head;
+
+    return true;
+}
+
+const QStringList& GraphSnapshot::getRefTips() const
+{
+    return refTips;
+}
+
+int GraphSnapshot::getLines() const
+{
+    return lines;
+}
+
+int GraphSnapshot::getHeadVersion() const
+{
+    return headVersion;
+}
+
+const QVector<GraphSnapshot::VersionRecord>& GraphSnapshot::getVersions() const
+{
+    return versions;
+}
+
+const QVector<GraphSnapshot::EdgeRecord>& GraphSnapshot::getEdges() const
+{
+    return edges;
+}
+
+CommitStore* GraphSnapshot::takeCommitStore()
+{
+    CommitStore* result = store;
+
+    store = NULL;
+
+    return result;
+}
@@ -0,0 +1,105 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __GRAPHSNAPSHOT_H__
+#define __GRAPHSNAPSHOT_H__
+
+#include <QGraphicsItem>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+class CommitStore;
+class Version;
+
+/**
+ * \brief On-disk copy of a loaded graph: the columns of the commit
+ *        store with the information of the versions, the tree
+ *        coordinates as arrays, the edges and the ref tips the graph
+ *        has been loaded for. Version i is row i of the store.
+ *        There is one snapshot per key, the key contains everything
+ *        the graph depends on (repository, git log arguments, sort).
+ *        A snapshot is written by the GitLogWorker after the layout
+ *        and read at the next start, so the previous graph is shown
+ *        without running git log. It is not validated here, the
+ *        refresh after the restore compares the ref tips.
+ *        A fingerprint of the graph is kept in the header, an
+ *        unchanged graph is not written again.
+ */
+class GraphSnapshot
+{
+public:
+    struct VersionRecord
+    {
+        float x;
+        int y;
+        bool main;
+        bool foldable;
+    };
+
+    struct EdgeRecord
+    {
+        // index in the version records, -1 is the root version
+        int source;
+        int dest;
+        bool merge;
+        bool info;
+    };
+
+    GraphSnapshot();
+    ~GraphSnapshot();
+
+    // write the graph below _root, false on error
+    static bool save(const QString& _key,
+                     const QStringList& _refTips,
+                     int _lines,
+                     const Version* _root,
+                     const Version* _headVersion,
+                     const QList<QGraphicsItem*>& _items);
+
+    // read the snapshot of _key, false if there is none
+    bool load(const QString& _key);
+
+    const QStringList& getRefTips() const;
+    int getLines() const;
+    int getHeadVersion() const;
+    const QVector<VersionRecord>& getVersions() const;
+    const QVector<EdgeRecord>& getEdges() const;
+
+    // hand over the commit store of the versions
+    CommitStore* takeCommitStore();
+
+    // file for _key below the folder _kind of the user cache directory
+    static QString cacheFileName(const QString& _kind, const QString& _key);
+
+private:
+    // fingerprint of the graph of _versions loaded for _refTips
+    static quint64 fingerprint(const QStringList& _refTips, int _lines, const QList<const Version*>& _versions);
+
+    // fingerprint in the header of the snapshot _path of _key, 0 if none
+    static quint64 readFingerprint(const QString& _path, const QString& _key);
+
+    QStringList refTips;
+    int lines;
+    int headVersion;
+    QVector<VersionRecord> versions;
+    QVector<EdgeRecord> edges;
+    CommitStore* store;
+};
+
+#endif
@@ -43,6 +43,15 @@
 
 #include "execute_cmd.h"
 #include "graphwidget.h"
+#include "commitstore.h"
+#include "gitlogworker.h"
+#include "graphsnapshot.h"
+#include "pathindex.h"
+#include "refdatabase.h"
+#include "commitinfo.h"
+#include "graphparser.h"
+#include "versionhashmap.h"
+#include "tagrules.h"
 #include "edge.h"
 #include "node.h"
 #include "mainwindow.h"
@@ -53,6 +62,9 @@
 
 using namespace std;
 
+// versions shown while a large graph is loaded
+static const int previewLines = 2000;
+
 string timestamp()
 {
     struct timeval tv;
@@ -87,7 +99,19 @@ GraphWidget::GraphWidget(MainWindow* _parent)
     yfactor(1),
     commentColumns(-1),
     commentMaxlen(-1),
-    selectedVersion(NULL)
+    selectedVersion(NULL),
+    gitlogWorker(NULL),
+    graphParser(NULL),
+    pathIndex(NULL),
+    pathIndexWorker(NULL),
+    refreshWorker(NULL),
+    pageWorker(NULL),
+    commitInfoCache(4 * 1024 * 1024),
+    commitInfoPrefetcher(NULL),
+    pendingParentsValid(false),
+    historyComplete(false),
+    nextPageScheduled(false),
+    commitStore(new CommitStore())
 {
 
     if (mwin)
@@ -99,6 +123,8 @@ GraphWidget::GraphWidget(MainWindow* _parent)
         topDownView = mwin->getTopDownView();
         horizontalSort = mwin->getHorizontalSort();
         remotes = mwin->getRemotes();
+        mwin->getCommentProperties(commentColumns, commentMaxlen);
+        adjustComments();
     }
 
     // scene
@@ -119,6 +145,28 @@ GraphWidget::GraphWidget(MainWindow* _parent)
     // imageDB["dot1"]= new QImage("dot4.png");
 }
 
+GraphWidget::~GraphWidget()
+{
+    // the workers, also outdated ones which have not finished yet,
+    // are children which refer to this widget and its members
+    QList<QThread*> workers = findChildren<QThread*>();
+
+    foreach(QThread * worker, workers)
+    {
+        worker->requestInterruption();
+    }
+    foreach(QThread * worker, workers)
+    {
+        worker->wait();
+    }
+
+    delete (graphParser);
+
+    // the versions are deleted with the scene, they do not
+    // access the store any more
+    delete (commitStore);
+}
+
 void GraphWidget::updateFromToInfo()
 {
     if (fromToInfo)
@@ -128,6 +176,7 @@ void GraphWidget::updateFromToInfo()
 void GraphWidget::test()
 {
     QMap<QString, Version*> nodes;
+    TagRules rules(mwin, changeableVersionInfo);
 
     QStringList nodeNames = (QStringList()
                              << "A" << "B" << "C" << "D" << "E" << "F" << "G" << "H"
@@ -135,11 +184,13 @@ void GraphWidget::test()
 
     foreach (const QString& n, nodeNames)
     {
-        QString line = "#0#0##(tag: " + n + ")#";
+        // the hash selects the row of the commit store
+        QString hash = QString::number(0xa0 + nodes.size(), 16);
+        QString line = "#" + hash + "#0##(tag: " + n + ")#";
         QStringList parts = line.split(QChar('#'));
 
         nodes[n] = new Version(globalVersionInfo, changeableVersionInfo, this);
-        nodes[n]->processGitLogInfo(line, parts);
+        nodes[n]->processGitLogInfo(commitStore, rules, parts);
 
         scene()->addItem(nodes[n]);
     }
@@ -328,6 +379,7 @@ void GraphWidget::scaleView(qreal scaleFactor)
 {
     transform().scale(scaleFactor, scaleFactor).mapRect(QRectF(0, 0, 1, 1)).width();
     scale(scaleFactor, scaleFactor);
+    checkNextPage();
 }
 
 void GraphWidget::zoomIn()
@@ -345,39 +397,34 @@ void GraphWidget::setGitLogFileConstraint(const QString& _fileConstraint)
     // redirected ;(
     mwin->updatePbFileConstraint(_fileConstraint);
 
-    // empty set
-    fileConstraintHashes = QSet<QString>();
-
     // keep file constraint
     fileConstraint = _fileConstraint;
 
+    // versions, where _fileConstraint has been touched: from the path
+    // index of the loaded graph, else from git log
+    bool indexed = pathIndex && pathIndex->isValid(gitlogRevisions(), refTips);
+    const PathIndex::CommitSet* commits = NULL;
+    QSet<QString> hashes;
+
     if (fileConstraint.isEmpty() == false)
     {
-        // get a list of all hashes, where _fileConstraint has been touched
-        QString cmd = "git -C "
-            + localRepositoryPath
-            + " log --pretty=\""
-            + (shortHashes ? "%h" : "%H")
-            + "\"";
-
-        if (remotes)
-            cmd += " --remotes";
-
-        if (all)
-            cmd += " --all";
-
-        if (!all && mwin->getSelectedBranch().size())
-            cmd += " " + mwin->getSelectedBranch();
-
-        if (fileConstraint.size())
-            cmd += " -- " + fileConstraint;
-
-        //
-        QList<QString> cache;
-        execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-        foreach(QString it, cache)
+        if (indexed)
+            commits = pathIndex->find(fileConstraint);
+        else
         {
-            fileConstraintHashes << it.trimmed();
+            QStringList cmd = QStringList()
+                << "git" << "-C" << localRepositoryPath
+                << "log" << (shortHashes ? "--pretty=%h" : "--pretty=%H")
+                << gitlogRevisions()
+                << "--" << fileConstraint;
+
+            //
+            QList<QString> cache;
+            execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
+            foreach(QString it, cache)
+            {
+                hashes << it.trimmed();
+            }
         }
     }
 
@@ -393,7 +440,17 @@ void GraphWidget::setGitLogFileConstraint(const QString& _fileConstraint)
             continue;
 
         v->clearFileConstraintEdgeList();
-        bool stat = v->getHash().size() && fileConstraintHashes.contains(v->getHash());
+
+        bool stat = false;
+
+        if (indexed)
+        {
+            int number = pathIndex->commitNumber(v->getObjectId());
+
+            stat = commits && number >= 0 && commits->contains(number);
+        }
+        else
+            stat = v->getHash().size() && hashes.contains(v->getHash());
 
         v->setFileConstraint(stat);
     }
@@ -422,26 +479,37 @@ Version* GraphWidget::gitlogSingle(QString _hash, bool _create)
     if (localRepositoryPath.isEmpty())
         return NULL;
 
-    QString cmd = "git -C "
-        + localRepositoryPath
-        + " log --graph -1 --pretty=\"#"
-        + (shortHashes ? "%h" : "%H")
-        + "#%at#%an#%d#%s#\"";
+    // HEAD is usually loaded, git log is only needed
+    // if it is outside the loaded versions
+    if (_hash.isEmpty())
+    {
+        Version* v = lookupVersion(resolveHeadRevision());
+
+        if (v)
+            return v;
+    }
+
+    QStringList cmd = QStringList()
+        << "git" << "-C" << localRepositoryPath
+        << "log" << "--graph" << "-1" << "--pretty=" + gitlogFormat();
 
     if (remotes)
-        cmd += " --remotes";
+        cmd << "--remotes";
 
     if (_hash.isEmpty() == false)
-        cmd += " " + _hash;
+        cmd << _hash;
     else if (!all && mwin->getSelectedBranch().size())
-        cmd += " " + mwin->getSelectedBranch();
+        cmd << mwin->getSelectedBranch();
 
     if (reduceTree == true && fileConstraint.size())
-        cmd += " -- " + fileConstraint;
+        cmd << "--" << fileConstraint;
 
     QList<QString> cache;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
+    execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
+
+    if (cache.isEmpty())
+        return NULL;
 
     QString line = cache.front();
 
@@ -464,14 +532,9 @@ Version* GraphWidget::gitlogSingle(QString _hash, bool _create)
         // create an object...
         v = new Version(globalVersionInfo, changeableVersionInfo, this);
 
-        // if the key information has already been parsed, use it
-        v->setKeyInformation(keyInformationCache.value(hash, QMap<QString, QStringList>()));
-
-        // init or update
-        if (v->processGitLogInfo(line, parts))
-        {
-            keyInformationCache[hash] = v->getKeyInformation();
-        }
+        // init or update, information which has already been
+        // parsed is taken from the commit store
+        v->processGitLogInfo(commitStore, TagRules(mwin, changeableVersionInfo), parts);
 
         mwin->getTagTree()->blockSignals(true);
         mwin->getTagTree()->addData(v);
@@ -482,52 +545,1193 @@ Version* GraphWidget::gitlogSingle(QString _hash, bool _create)
     return v;
 }
 
+QString GraphWidget::resolveHeadRevision() const
+{
+    QString branch = (!all) ? mwin->getSelectedBranch() : QString();
+    QStringList prefixes("refs/heads/");
+
+    if (branch.size())
+        prefixes << "refs/remotes/";
+
+    RefDatabase refDatabase;
+
+    if (!refDatabase.read(localRepositoryPath, prefixes))
+        return QString();
+
+    QString ref = refDatabase.getHead();
+
+    // short name of a local or remote branch
+    if (branch.size())
+    {
+        ref = "refs/heads/" + branch;
+
+        if (!refDatabase.getRefs().contains(ref))
+            ref = "refs/remotes/" + branch;
+    }
+
+    // detached HEAD
+    if (!ref.startsWith("refs/"))
+        return ref;
+
+    return refDatabase.getRefs().value(ref);
+}
+
 void GraphWidget::gitlog(bool _changed)
 {
     if (_changed)
     {
-        keyInformationCache.clear();
         resetSelection();
     }
 
+    // a running load is outdated now
+    cancelGitlog();
+
+    QString format = gitlogFormat();
+    QStringList revisions = gitlogRevisions();
+    QStringList args = revisions;
+
+    if (reduceTree == true && fileConstraint.size())
+        args << "--" << fileConstraint;
+
+    QStringList git = QStringList() << "git" << "-C" << localRepositoryPath;
+
+    QStringList cmd = QStringList(git)
+        << "log" << "--graph" << "--pretty=" + format
+        << args;
+
+    // The topology is read from the commit-graph file, without it
+    // from the parent hashes and git log --graph is the last fallback.
+    // --parents rewrites the parents of a file constraint like --graph
+    // does. The incremental refresh needs the ref tips of the load,
+    // it does not support a file constraint.
+    QStringList parentsCmd = QStringList(git)
+        << "log" << "--topo-order" << "--parents" << "--pretty=%H %P" + format
+        << args;
+    QStringList commitGraphCmd;
+    QStringList tipsCmd;
+
+    if (reduceTree == false || fileConstraint.isEmpty())
+    {
+        // The commit-graph file holds the real parents, with
+        // a file constraint the rewritten ones are needed.
+        commitGraphCmd = QStringList(git)
+            << "log" << "--topo-order" << "--pretty=%H" + format
+            << args;
+
+        tipsCmd = QStringList(git)
+            << "log" << "--no-walk" << "--pretty=%H"
+            << (revisions.isEmpty() ? QStringList("HEAD") : revisions);
+    }
+
+    refTips.clear();
+    refTipsRevisions = revisions;
+
+    // everything the loaded graph depends on
+    QString snapshotKey;
+
+    if (tipsCmd.isEmpty() == false)
+    {
+        snapshotKey = (QStringList(cmd)
+                       << QString::number(maxLines)
+                       << QString::number(mwin->getHorizontalSort())
+                       << globalVersionInfo
+                       << changeableVersionInfo
+                       << TagRules(mwin, changeableVersionInfo).toString()).join(QChar('\n'));
+    }
+
+    // the graph of the last session is shown at once, the
+    // refresh afterwards inserts what has changed since then
+    if (snapshotKey.size() && (_changed || headVersion == NULL) && restoreSnapshot(snapshotKey))
+    {
+        QTimer::singleShot(0, this, SLOT(verifySnapshot()));
+        return;
+    }
+
+    // git log, parsing and layout are done in a background thread,
+    // the current graph stays in place until gitlogWorkerFinished()
+    gitlogWorker = new GitLogWorker(this,
+                                    cmd,
+                                    commitGraphCmd,
+                                    parentsCmd,
+                                    tipsCmd,
+                                    localRepositoryPath,
+                                    maxLines,
+                                    mwin->getHorizontalSort(),
+                                    mwin->getPrintCmdToStdout(),
+                                    globalVersionInfo,
+                                    changeableVersionInfo,
+                                    _changed ? new CommitStore() : new CommitStore(*commitStore),
+                                    TagRules(mwin, changeableVersionInfo));
+
+    gitlogWorker->setSnapshotKey(snapshotKey);
+
+    // the newest versions are shown at once, a graph which is
+    // already shown stays in place until the load is complete
+    if (_changed || headVersion == NULL)
+        gitlogWorker->setPreviewLines(previewLines);
+
+    connect(gitlogWorker, SIGNAL(progress(int, int)), this, SLOT(gitlogProgress(int, int)));
+    connect(gitlogWorker, SIGNAL(previewReady()), this, SLOT(gitlogPreviewReady()));
+    connect(gitlogWorker, SIGNAL(finished()), this, SLOT(gitlogWorkerFinished()));
+
+    mwin->showLoadProgress(0);
+    gitlogWorker->start();
+}
+
+void GraphWidget::cancelGitlog()
+{
+    // a refresh of the former graph is outdated, too
+    cancelRefresh();
+
+    if (!gitlogWorker)
+        return;
+
+    // the worker deletes its versions and edges, if they are not taken
+    disconnect(gitlogWorker, NULL, this, NULL);
+    connect(gitlogWorker, SIGNAL(finished()), gitlogWorker, SLOT(deleteLater()));
+    gitlogWorker->requestInterruption();
+    if (gitlogWorker->isFinished())
+        gitlogWorker->deleteLater();
+
+    gitlogWorker = NULL;
+    mwin->hideLoadProgress();
+}
+
+void GraphWidget::gitlogProgress(int _lines, int _expectedLines)
+{
+    if (sender() == gitlogWorker)
+        mwin->showLoadProgress(_lines, _expectedLines);
+}
+
+void GraphWidget::gitlogPreviewReady()
+{
+    GitLogWorker* worker = dynamic_cast<GitLogWorker*>(sender());
+
+    // outdated or cancelled load
+    if (!worker || worker != gitlogWorker)
+        return;
+
+    Version* root = NULL;
+    Version* head = NULL;
+    QList<QGraphicsItem*> items;
+    CommitStore* store = NULL;
+
+    if (worker->takePreview(root, items, head, store) == false)
+        return;
+
+    // paging and refresh wait for the complete graph
+    currentLines = worker->getPreviewLines();
+
+    setGraph(root, items, head, store);
+}
+
+void GraphWidget::gitlogWorkerFinished()
+{
+    GitLogWorker* worker = dynamic_cast<GitLogWorker*>(sender());
+
+    // outdated or cancelled load
+    if (!worker || worker != gitlogWorker)
+        return;
+
+    gitlogWorker = NULL;
+    worker->deleteLater();
+    mwin->hideLoadProgress();
+
+    Version* root = NULL;
+    Version* head = NULL;
+    QList<QGraphicsItem*> items;
+    CommitStore* store = NULL;
+
+    if (worker->takeResult(root, items, head, store) == false)
+        return;
+
+    currentLines = worker->getLines();
+    refTips = worker->getRefTips();
+
+    setGraph(root, items, head, store);
+    updatePathIndex();
+
+    emit loadFinished();
+}
+
+void GraphWidget::updatePathIndex()
+{
+    QStringList revisions = gitlogRevisions();
+
+    // not loaded by ref tips, e.g. with a reducing file constraint
+    if (refTips.isEmpty() || refTipsRevisions != revisions)
+        return;
+
+    if (pathIndex && pathIndex->isValid(revisions, refTips))
+        return;
+
+    // an outdated build is dropped when it has finished
+    if (pathIndexWorker)
+    {
+        disconnect(pathIndexWorker, NULL, this, NULL);
+        connect(pathIndexWorker, SIGNAL(finished()), pathIndexWorker, SLOT(deleteLater()));
+        pathIndexWorker->requestInterruption();
+        if (pathIndexWorker->isFinished())
+            pathIndexWorker->deleteLater();
+    }
+
+    // the current index is updated by the commits added since then
+    pathIndexWorker = new PathIndexWorker(localRepositoryPath, revisions, refTips, pathIndex, mwin->getPrintCmdToStdout(), this);
+    connect(pathIndexWorker, SIGNAL(finished()), this, SLOT(pathIndexWorkerFinished()));
+    pathIndexWorker->start(QThread::LowPriority);
+}
+
+void GraphWidget::pathIndexWorkerFinished()
+{
+    PathIndexWorker* worker = dynamic_cast<PathIndexWorker*>(sender());
+
+    if (!worker || worker != pathIndexWorker)
+        return;
+
+    pathIndexWorker = NULL;
+    worker->deleteLater();
+
+    PathIndex* index = worker->takeIndex();
+
+    if (!index)
+        return;
+
+    delete (pathIndex);
+    pathIndex = index;
+}
+
+void GraphWidget::setGraph(Version* _root, const QList<QGraphicsItem*>& _items, Version* _headVersion, CommitStore* _store)
+{
+    // swap in the new graph
     setUpdatesEnabled(false);
 
     saveImportantVersions();
 
-    clear();
+    connectorStyle = mwin->getConnectorStyle();
+
+    clear(_root);
+    headVersion = _headVersion;
+
+    // git log has ended before maxLines, there is no older page
+    historyComplete = currentLines <= maxLines;
+
+    // the former versions are gone, so is their information
+    delete (commitStore);
+    commitStore = _store;
+
+    mwin->getTagTree()->blockSignals(true);
+    mwin->getTagTree()->resetTagTree();
+
+    addGraphItems(_items);
+    processFinish();
+
+    adjustComments();
+
+    restoreImportantVersions();
+    setUpdatesEnabled(true);
+
+    checkNextPage();
+}
+
+bool GraphWidget::restoreSnapshot(const QString& _key)
+{
+    GraphSnapshot snapshot;
+
+    if (!snapshot.load(_key))
+        return false;
+
+    const QVector<GraphSnapshot::VersionRecord>& records = snapshot.getVersions();
+    QVector<Version*> versions(records.size());
+    QList<QGraphicsItem*> items;
+
+    // version i is row i of the store
+    CommitStore* store = snapshot.takeCommitStore();
+
+    for (int i = 0; i < records.size(); i++)
+    {
+        const GraphSnapshot::VersionRecord& r = records.at(i);
+
+        // the information is taken as it is, nothing is parsed
+        Version* v = new Version(globalVersionInfo, changeableVersionInfo, this);
+
+        v->setCommitStoreRow(store, i);
+        v->setIsFoldable(r.foldable);
+        v->setIsMain(r.main);
+        v->setX(r.x);
+        v->setY(r.y);
+        items.push_back(v);
+        versions[i] = v;
+    }
 
-    QString cmd = "git -C "
-        + localRepositoryPath
-        + " log --graph --pretty=\"#"
-        + (shortHashes ? "%h" : "%H")
-        + "#%at#%an#%d#%s#\"";
+    Version* root = new Version(this);
+
+    foreach(const GraphSnapshot::EdgeRecord& r, snapshot.getEdges())
+    {
+        Edge* e = new Edge(r.source == -1 ? root : versions.at(r.source),
+                           versions.at(r.dest),
+                           this,
+                           r.merge,
+                           r.info);
+
+        items.push_back(e);
+    }
+
+    // the coordinates are those of the snapshot, no layout
+    root->collectFolderVersions(root, NULL);
+
+    currentLines = snapshot.getLines();
+    refTips = snapshot.getRefTips();
+
+    setGraph(root,
+             items,
+             snapshot.getHeadVersion() == -1 ? NULL : versions.at(snapshot.getHeadVersion()),
+             store);
+    updatePathIndex();
+
+    emit loadFinished();
+
+    return true;
+}
+
+void GraphWidget::verifySnapshot()
+{
+    // a reload has been started in the meantime
+    if (gitlogWorker == NULL)
+        refresh();
+}
+
+QString GraphWidget::gitlogFormat() const
+{
+    return QString("#")
+           + (shortHashes ? "%h" : "%H")
+           + "#%at#%an#%d#%s#";
+}
+
+QStringList GraphWidget::gitlogRevisions() const
+{
+    QStringList revisions;
 
     if (remotes)
-        cmd += " --remotes";
+        revisions << "--remotes";
 
     if (all)
-        cmd += " --all";
+        revisions << "--all";
 
     if (!all && mwin->getSelectedBranch().size())
-        cmd += " " + mwin->getSelectedBranch();
+        revisions << mwin->getSelectedBranch();
 
-    if (reduceTree == true && fileConstraint.size())
-        cmd += " -- " + fileConstraint;
+    return revisions;
+}
 
-    QList<QString> cache;
+void GraphWidget::refresh()
+{
+    if (gitlogIncremental() == false)
+        gitlog();
+}
+
+bool GraphWidget::gitlogIncremental()
+{
+    // a load is running or the settings have changed since the last load
+    if (gitlogWorker
+        || refTips.isEmpty()
+        || refTipsRevisions != gitlogRevisions()
+        || (reduceTree == true && fileConstraint.size()))
+        return false;
+
+    // the ref tips may have changed again, a page read
+    // now would miss the parents of the new commits
+    cancelRefresh();
+    cancelNextPage();
+
+    QStringList revisions = refTipsRevisions.isEmpty() ? QStringList("HEAD") : refTipsRevisions;
+
+    // refs may have moved away from loaded versions
+    QStringList decorated;
+
+    foreach(QGraphicsItem * it, scene()->items())
+    {
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
+
+        Version* v = dynamic_cast<Version*>(it);
+
+        if (v && !v->getObjectId().isNull() && v->numEdges()
+            && v->getDecoration().trimmed().size())
+            decorated.push_back(v->getHash());
+    }
+
+    // git is run in the background, the graph is changed by
+    // refreshWorkerFinished()
+    refreshWorker = new GitRefreshWorker(localRepositoryPath,
+                                         revisions,
+                                         refTips,
+                                         decorated,
+                                         gitlogFormat(),
+                                         maxLines,
+                                         mwin->getPrintCmdToStdout(),
+                                         this);
+
+    connect(refreshWorker, SIGNAL(finished()), this, SLOT(refreshWorkerFinished()));
+    refreshWorker->start();
+
+    return true;
+}
+
+void GraphWidget::cancelRefresh()
+{
+    if (!refreshWorker)
+        return;
+
+    disconnect(refreshWorker, NULL, this, NULL);
+    connect(refreshWorker, SIGNAL(finished()), refreshWorker, SLOT(deleteLater()));
+    refreshWorker->requestInterruption();
+    if (refreshWorker->isFinished())
+        refreshWorker->deleteLater();
+
+    refreshWorker = NULL;
+}
+
+void GraphWidget::refreshWorkerFinished()
+{
+    GitRefreshWorker* worker = dynamic_cast<GitRefreshWorker*>(sender());
+
+    // outdated or cancelled refresh
+    if (!worker || worker != refreshWorker)
+        return;
+
+    refreshWorker = NULL;
+    worker->deleteLater();
+
+    // the graph has been loaded again in the meantime
+    if (gitlogWorker || worker->getBaseRefTips() != refTips)
+        return;
+
+    // e.g. history has been rewritten or there is more than a page
+    if (worker->isComplete() == false
+        || applyIncremental(worker->getRefTips(), worker->getLines(), worker->getDecorationLines()) == false)
+        gitlog();
+    else
+        checkNextPage();
+}
+
+// the object ids of "<oid> <parent oids>"
+static QStringList splitIds(const QString& _ids)
+{
+    QStringList ids;
+
+    foreach(const QString& id, _ids.split(QChar(' ')))
+    {
+        if (id.size())
+            ids.push_back(id);
+    }
+
+    return ids;
+}
+
+bool GraphWidget::applyIncremental(const QStringList& _tips,
+                                   const QList<QString>& _lines,
+                                   const QList<QString>& _decorationLines)
+{
+    // the settings have changed since the refresh has been started
+    if (refTipsRevisions != gitlogRevisions()
+        || (reduceTree == true && fileConstraint.size()))
+        return false;
+
+    // all loaded versions
+    QHash<QString, Version*> versions;
+
+    foreach(QGraphicsItem * it, scene()->items())
+    {
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
+
+        Version* v = dynamic_cast<Version*>(it);
+
+        // skip a selected version restored without edges
+        if (v && !v->getObjectId().isNull() && v->numEdges())
+            versions.insert(v->getHash(), v);
+    }
+
+    // check the new commits before the graph is touched,
+    // the object ids are not abbreviated
+    QSet<QString> newIds;
+
+    for (int i = _lines.size() - 1; i >= 0; i--)
+    {
+        const QString& line = _lines.at(i);
+        int sep = line.indexOf(QChar('#'));
+        QStringList parts = line.mid(sep).split(QChar('#'));
+        QStringList ids = splitIds(line.left(sep));
+
+        if (sep == -1 || parts.size() < 6 || ids.isEmpty())
+        {
+            cerr << "Error: Input too short " << line.toUtf8().data() << endl;
+            return false;
+        }
+
+        // the first parent must be part of the graph
+        if (ids.size() > 1 && !newIds.contains(ids.at(1)) && !lookupLoaded(ids.at(1)))
+            return false;
+
+        newIds.insert(ids.at(0));
+    }
+
+    setUpdatesEnabled(false);
+
+    QPoint anchorViewPosition;
+    Version* anchor = viewAnchor(anchorViewPosition);
+
+    // insert the new versions, root first
+    QList<Version*> added;
+    QHash<QString, Version*> addedIds;
+    QHash<Version*, Version*> firstParents;
+
+    // loaded versions which got new edges
+    QList<Version*> touched;
+    TagRules rules(mwin, changeableVersionInfo);
+
+    for (int i = _lines.size() - 1; i >= 0; i--)
+    {
+        const QString& line = _lines.at(i);
+        int sep = line.indexOf(QChar('#'));
+        QString info = line.mid(sep);
+        QStringList parts = info.split(QChar('#'));
+        QString hash = parts.at(1);
+
+        QStringList ids = splitIds(line.left(sep));
+        QString oid = ids.takeFirst();
+
+        // already loaded, if a commit has been added during the last load
+        if (addedIds.contains(oid) || lookupLoaded(oid))
+            continue;
+
+        Version* v = new Version(globalVersionInfo, changeableVersionInfo, this);
+
+        // init or update, information which has already been
+        // parsed is taken from the commit store
+        v->processGitLogInfo(commitStore, rules, parts);
+
+        v->setIsFoldable(rules.isFoldable(v->getInformationKeys()));
+        v->setIsMain(false);
+        scene()->addItem(v);
+
+        Version* parent = ids.size() ? addedIds.value(ids.at(0), lookupLoaded(ids.at(0))) : NULL;
+
+        Edge* e = new Edge (parent ? parent : rootVersion, v, this, false, parent == NULL);
+        scene()->addItem(e);
+        firstParents.insert(v, parent);
+
+        if (!parent)
+            touched.push_back(rootVersion);
+        else if (!firstParents.contains(parent))
+            touched.push_back(parent);
+
+        for (int j = 1; j < ids.size(); j++)
+        {
+            Version* merge = addedIds.value(ids.at(j), lookupLoaded(ids.at(j)));
+
+            // a merge of history which has not been loaded yet
+            // is linked by a later page
+            if (merge == NULL && pendingParentsValid)
+                pendingParents[ids.at(j)].push_back(PendingChild(v, false));
+
+            if (merge == NULL || merge == parent)
+                continue;
+
+            Edge* mergeArrow = new Edge(merge, v, this, true, false);
+
+            scene()->addItem(mergeArrow);
+
+            // a merge source may not be part of a folder any more
+            if (!firstParents.contains(merge))
+                touched.push_back(merge);
+        }
+
+        versions.insert(hash, v);
+        addedIds.insert(oid, v);
+        added.push_back(v);
+    }
+
+    // refs may have moved to or away from loaded versions:
+    // update all versions with a decoration and all ref targets
+    bool decorationChanged = false;
+
+    foreach (const QString& info, _decorationLines)
+    {
+        QStringList parts = info.split(QChar('#'));
+
+        if (parts.size() < 6)
+            continue;
+
+        Version* v = versions.value(parts.at(1), NULL);
+
+        if (!v || firstParents.contains(v))
+            continue;
+
+        if (v->processGitLogInfo(commitStore, rules, parts))
+        {
+            v->setIsFoldable(rules.isFoldable(v->getInformationKeys()));
+            v->calculateLocalBoundingBox();
+            v->update();
+            decorationChanged = true;
+        }
+    }
+
+    refTips = _tips;
+    updatePathIndex();
+
+    // e.g. only the working tree has changed
+    if (added.isEmpty() && decorationChanged == false)
+    {
+        setUpdatesEnabled(true);
+        emit loadFinished();
+        return true;
+    }
+
+    // the first parent line of the newest commit is main,
+    // if it continues the main line
+    if (added.size())
+    {
+        QList<Version*> mainLine;
+        Version* v = added.last();
+
+        while (v && firstParents.contains(v))
+        {
+            mainLine.push_back(v);
+            v = firstParents.value(v);
+        }
+
+        if (v && v->isMain())
+        {
+            foreach(Version * m, mainLine)
+            {
+                m->setIsMain(true);
+            }
+            headVersion = added.last();
+        }
+    }
+
+    // TagTree has no removal, so it is rebuilt if a decoration has moved
+    mwin->getTagTree()->blockSignals(true);
+    if (decorationChanged)
+    {
+        mwin->getTagTree()->resetTagTree();
+        foreach(Version * v, versions)
+        {
+            mwin->getTagTree()->addData(v);
+        }
+    }
+    else
+    {
+        foreach(Version * v, added)
+        {
+            mwin->getTagTree()->addData(v);
+        }
+    }
+
+    currentLines += added.size();
+
+    // layout of the extended tree, no version is created again:
+    // only the subtree with the new versions is arranged again if it
+    // still fits, a moved decoration may change folders everywhere
+    Version* layoutRoot = decorationChanged ? rootVersion : layoutAnchor(touched);
+
+    updateFolders(layoutRoot);
+    if (layoutRoot == rootVersion || layoutSubtree(layoutRoot) == false)
+        layoutTree(rootVersion, mwin->getHorizontalSort());
+
+    processFinish(false);
+    restoreViewAnchor(anchor, anchorViewPosition);
+
+    setUpdatesEnabled(true);
+
+    emit loadFinished();
+
+    return true;
+}
+
+Version* GraphWidget::viewAnchor(QPoint& _viewPosition)
+{
+    // keep the view in place: the selected version or the one next
+    // to the center of the view
+    QPointF center = mapToScene(viewport()->rect().center());
+    Version* anchor = selectedVersion;
+
+    if (!anchor)
+    {
+        qreal distance = -1;
+
+        foreach(Version * v, versionIndex.values())
+        {
+            QPointF d = v->pos() - center;
+            qreal dd = d.x() * d.x() + d.y() * d.y();
+
+            if (v->isVisible() && (distance < 0 || dd < distance))
+            {
+                anchor = v;
+                distance = dd;
+            }
+        }
+    }
+
+    _viewPosition = anchor ? mapFromScene(anchor->pos()) : QPoint();
+
+    return anchor;
+}
+
+void GraphWidget::restoreViewAnchor(Version* _anchor, const QPoint& _viewPosition)
+{
+    if (!_anchor)
+        return;
+
+    QPoint shift = mapFromScene(_anchor->pos()) - _viewPosition;
+
+    horizontalScrollBar()->setValue(horizontalScrollBar()->value() + shift.x());
+    verticalScrollBar()->setValue(verticalScrollBar()->value() + shift.y());
+}
+
+void GraphWidget::collectPendingParents(const GitPageWorker* _worker)
+{
+    pendingParents.clear();
+
+    // the graph may have changed since the parents have been read,
+    // skip a selected version restored without edges
+    foreach(const GitPageWorker::Boundary& b, _worker->getBoundary())
+    {
+        Version* child = lookupVersion(b.child);
+        Version* v = lookupVersion(b.parent);
+
+        if (child && child->numEdges() && (!v || v->numEdges() == 0))
+            pendingParents[b.parent].push_back(PendingChild(child, b.firstParent));
+    }
+
+    pendingParentsValid = true;
+}
+
+bool GraphWidget::gitlogNextPage()
+{
+    // same conditions as for the incremental refresh
+    if (gitlogWorker || refreshWorker || pageWorker
+        || historyComplete
+        || refTips.isEmpty()
+        || refTipsRevisions != gitlogRevisions()
+        || (reduceTree == true && fileConstraint.size()))
+        return false;
+
+    // the parents of the loaded versions are read by the worker,
+    // if they are not known
+    QStringList loaded;
+    QStringList pending;
+
+    if (pendingParentsValid)
+    {
+        if (pendingParents.isEmpty())
+        {
+            historyComplete = true;
+            return false;
+        }
+        pending = pendingParents.keys();
+    }
+    else
+    {
+        foreach(Version * v, versionIndex.values())
+        {
+            if (v->numEdges())
+                loaded.push_back(v->getHash());
+        }
+    }
+
+    pageWorker = new GitPageWorker(localRepositoryPath,
+                                   loaded,
+                                   pending,
+                                   gitlogFormat(),
+                                   maxLines,
+                                   mwin->getPrintCmdToStdout(),
+                                   this);
+
+    connect(pageWorker, SIGNAL(finished()), this, SLOT(pageWorkerFinished()));
+    pageWorker->start();
+
+    return true;
+}
+
+void GraphWidget::cancelNextPage()
+{
+    if (!pageWorker)
+        return;
+
+    disconnect(pageWorker, NULL, this, NULL);
+    connect(pageWorker, SIGNAL(finished()), pageWorker, SLOT(deleteLater()));
+    pageWorker->requestInterruption();
+    if (pageWorker->isFinished())
+        pageWorker->deleteLater();
+
+    pageWorker = NULL;
+}
+
+void GraphWidget::pageWorkerFinished()
+{
+    GitPageWorker* worker = dynamic_cast<GitPageWorker*>(sender());
+
+    // outdated or cancelled page
+    if (!worker || worker != pageWorker)
+        return;
+
+    pageWorker = NULL;
+    worker->deleteLater();
+
+    if (worker->isComplete() == false)
+        return;
+
+    if (!pendingParentsValid)
+        collectPendingParents(worker);
+
+    // the root may still be close to the view
+    if (applyNextPage(worker->getLines()))
+        checkNextPage();
+}
+
+bool GraphWidget::applyNextPage(const QList<QString>& _lines)
+{
+    // check the page before the graph is touched
+    foreach(const QString& line, _lines)
+    {
+        int sep = line.indexOf(QChar('#'));
+
+        if (sep == -1 || line.mid(sep).split(QChar('#')).size() < 6)
+        {
+            cerr << "Error: Input too short " << line.toUtf8().data() << endl;
+            return false;
+        }
+    }
+
+    if (_lines.isEmpty())
+    {
+        historyComplete = true;
+        return false;
+    }
+
+    setUpdatesEnabled(false);
+
+    QPoint anchorViewPosition;
+    Version* anchor = viewAnchor(anchorViewPosition);
+
+    // insert the page, root first, by object id
+    QHash<QString, Version*> added;
+    QList<Version*> addedVersions;
+    QHash<Version*, Version*> firstParents;
+    QList<Version*> mainLines;
+    TagRules rules(mwin, changeableVersionInfo);
+
+    for (int i = _lines.size() - 1; i >= 0; i--)
+    {
+        const QString& line = _lines.at(i);
+        int sep = line.indexOf(QChar('#'));
+        QString info = line.mid(sep);
+        QStringList parts = info.split(QChar('#'));
+        QStringList ids = splitIds(line.left(sep));
+
+        if (ids.isEmpty())
+            continue;
+
+        QString oid = ids.takeFirst();
+        Version* loaded = lookupVersion(oid);
+
+        // already loaded, e.g. by a refresh since the parents were collected
+        if (added.contains(oid) || (loaded && loaded->numEdges()))
+            continue;
+
+        Version* v = new Version(globalVersionInfo, changeableVersionInfo, this);
+
+        // init or update, information which has already been
+        // parsed is taken from the commit store
+        v->processGitLogInfo(commitStore, rules, parts);
+
+        v->setIsFoldable(rules.isFoldable(v->getInformationKeys()));
+        v->setIsMain(false);
+        scene()->addItem(v);
+
+        // the parents are part of this page or of a later one
+        Version* parent = ids.size() ? added.value(ids.at(0), NULL) : NULL;
+
+        Edge* e = new Edge (parent ? parent : rootVersion, v, this, false, parent == NULL);
+        scene()->addItem(e);
+        firstParents.insert(v, parent);
+
+        for (int j = 0; j < ids.size(); j++)
+        {
+            Version* p = added.value(ids.at(j), NULL);
+
+            if (p == NULL)
+                pendingParents[ids.at(j)].push_back(PendingChild(v, j == 0));
+            else if (j > 0 && p != parent)
+                scene()->addItem(new Edge(p, v, this, true, false));
+        }
+
+        // loaded children waiting for this version
+        foreach(const PendingChild& child, pendingParents.take(oid))
+        {
+            if (child.firstParent == false)
+            {
+                scene()->addItem(new Edge(v, child.version, this, true, false));
+                continue;
+            }
+
+            // the child has been attached to the root so far
+            foreach(Edge * rootEdge, rootVersion->getOutEdges())
+            {
+                if (rootEdge->destVersion() == child.version)
+                {
+                    rootVersion->removeEdge(rootEdge);
+                    child.version->removeEdge(rootEdge);
+                    scene()->removeItem(rootEdge);
+                    delete (rootEdge);
+                    break;
+                }
+            }
+
+            scene()->addItem(new Edge(v, child.version, this, false, false));
+
+            if (child.version->isMain())
+                mainLines.push_back(v);
+        }
+
+        added.insert(oid, v);
+        addedVersions.push_back(v);
+    }
+
+    // the main line continues along the first parents
+    foreach(Version * v, mainLines)
+    {
+        for (; v != NULL; v = firstParents.value(v, NULL))
+        {
+            v->setIsMain(true);
+        }
+    }
+
+    mwin->getTagTree()->blockSignals(true);
+    foreach(Version * v, addedVersions)
+    {
+        mwin->getTagTree()->addData(v);
+    }
+
+    currentLines += addedVersions.size();
+
+    // layout of the extended tree, no version is created again
+    updateFolders();
+    layoutTree(rootVersion, mwin->getHorizontalSort());
+
+    processFinish(false);
+    restoreViewAnchor(anchor, anchorViewPosition);
+
+    if (pendingParents.isEmpty())
+        historyComplete = true;
+
+    setUpdatesEnabled(true);
+
+    emit loadFinished();
+
+    return true;
+}
+
+void GraphWidget::checkNextPage()
+{
+    if (historyComplete || nextPageScheduled || !rootVersion)
+        return;
+
+    // the root is the oldest edge of the graph, the next page is
+    // loaded when it is less than a view height away
+    QRectF visible = mapToScene(viewport()->rect()).boundingRect();
+    qreal y = rootVersion->pos().y();
+
+    if (y < visible.top() - visible.height() || y > visible.bottom() + visible.height())
+        return;
+
+    nextPageScheduled = true;
+    QTimer::singleShot(0, this, SLOT(loadNextPage()));
+}
+
+void GraphWidget::loadNextPage()
+{
+    nextPageScheduled = false;
+    gitlogNextPage();
+}
+
+void GraphWidget::scrollContentsBy(int _dx, int _dy)
+{
+    QGraphicsView::scrollContentsBy(_dx, _dy);
+    checkNextPage();
+}
+
+// parent in the tree, set by Version::linkTreenodes()
+static Version* treeParent(const Version* _v)
+{
+    return dynamic_cast<Version*>(_v->parentItem());
+}
+
+// _v and all versions below it in the tree
+static QList<Version*> subtreeVersions(Version* _v)
+{
+    QList<Version*> result;
+
+    result.push_back(_v);
+    for (int i = 0; i < result.size(); i++)
+    {
+        foreach (const Edge * edge, result.at(i)->getOutEdges())
+        {
+            Version* next = dynamic_cast<Version*>(edge->destVersion());
+
+            if (next)
+                result.push_back(next);
+        }
+    }
+
+    return result;
+}
+
+void GraphWidget::updateFolders(Version* _anchor)
+{
+    Version* anchor = _anchor ? _anchor : rootVersion;
+    QList<Version*> subtree = subtreeVersions(anchor);
+
+    // versions of unfolded folders
+    QSet<Version*> unfolded;
+
+    foreach(Version * v, subtree)
+    {
+        if (v->isFolder() && !v->isFolded())
+        {
+            unfolded.insert(v);
+            foreach(Version * f, v->getFolderVersions())
+            {
+                unfolded.insert(f);
+            }
+        }
+    }
+
+    anchor->flattenFoldersRecurse();
+    anchor->updateFoldableRecurse();
+    anchor->collectFolderVersions(rootVersion, anchor == rootVersion ? NULL : treeParent(anchor));
+
+    // consistent folded state of all folders and their versions
+    anchor->foldRecurse(false);
+    anchor->foldRecurse(true);
+
+    foreach(Version * v, subtree)
+    {
+        if (!v->isFolder())
+            continue;
+
+        bool open = unfolded.contains(v);
+
+        foreach(Version * f, v->getFolderVersions())
+        {
+            open = open || unfolded.contains(f);
+        }
+
+        if (open)
+            v->foldAction();
+    }
+}
+
+Version* GraphWidget::layoutAnchor(const QList<Version*>& _touched) const
+{
+    // path from the anchor up to the root version
+    QList<Version*> path;
+
+    foreach (Version * v, _touched)
+    {
+        if (path.isEmpty())
+        {
+            for (Version* a = v; a; a = treeParent(a))
+            {
+                path.push_back(a);
+            }
+            continue;
+        }
+
+        Version* a = v;
+
+        while (a && !path.contains(a))
+        {
+            a = treeParent(a);
+        }
+
+        // not linked to the root version
+        if (!a)
+            return rootVersion;
+
+        path = path.mid(path.indexOf(a));
+    }
+
+    if (path.isEmpty() || path.last() != rootVersion)
+        return rootVersion;
+
+    Version* anchor = path.front();
+
+    // a folder may begin above the anchor
+    for (Version* p = treeParent(anchor);
+         p && p != rootVersion && p->getNumOutEdges() == 1 && p->isFoldable();
+         p = treeParent(anchor))
+    {
+        anchor = p;
+    }
+
+    return anchor;
+}
+
+bool GraphWidget::layoutSubtree(Version* _anchor)
+{
+    int sort = mwin->getHorizontalSort();
+
+    // the order of the siblings of all ancestors depends
+    // on the weight of their subtrees
+    if (sort == 1 || sort == 2)
+        return false;
+
+    // the layout keeps the position of the root of the tree
+    layoutTree(_anchor, sort);
+
+    // left and right x of the subtree on each level
+    QList<Version*> subtree = subtreeVersions(_anchor);
+    QSet<Version*> inside;
+    QHash<int, QPair<float, float> > contour;
+
+    foreach (Version * v, subtree)
+    {
+        inside.insert(v);
+
+        if (!contour.contains(v->getY()))
+            contour.insert(v->getY(), qMakePair(v->getX(), v->getX()));
+        else
+        {
+            QPair<float, float>& c = contour[v->getY()];
+
+            c.first = qMin(c.first, v->getX());
+            c.second = qMax(c.second, v->getX());
+        }
+    }
+
+    // the neighbours must keep a distance of 1
+    foreach(QGraphicsItem * it, scene()->items())
+    {
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-    process(cache);
+        Version* v = dynamic_cast<Version*>(it);
 
-    adjustComments();
+        if (!v || v == rootVersion || v->numEdges() == 0 || inside.contains(v))
+            continue;
 
-    restoreImportantVersions();
-    setUpdatesEnabled(true);
+        QHash<int, QPair<float, float> >::const_iterator c = contour.constFind(v->getY());
 
-    if (reduceTree == false && fileConstraint.isEmpty() == false)
-    {
-        setGitLogFileConstraint(fileConstraint);
+        if (c != contour.constEnd()
+            && v->getX() > c.value().first - 0.999f
+            && v->getX() < c.value().second + 0.999f)
+            return false;
     }
+
+    return true;
 }
 
 void GraphWidget::setCompareTree(CompareTree* _tree)
@@ -550,38 +1754,22 @@ void GraphWidget::load(const QString& _path)
     setUpdatesEnabled(false);
 
     QFile file(_path);
-    QList<QString> cache;
+
+    processBegin();
 
     if (file.open(QFile::ReadOnly | QFile::Text))
     {
-        char buffer[65536];
         while (!file.atEnd())
         {
-            file.readLine(buffer, 65535);
-            cache.push_back(QString(buffer));
+            if (processAppend(file.readLine()) == false)
+                break;
         }
         file.close();
     }
-    process(cache);
 
-    setUpdatesEnabled(true);
-}
+    processEnd();
 
-void GraphWidget::debugExit(char _c,
-                            int _column,
-                            int _lineNumber,
-                            const QString& _tree,
-                            const QString& _previousTree,
-                            const QString& _line)
-{
-    cerr << "Unknown sequence: current [" << _c
-         << "] line [" << _lineNumber << "] column [" << _column << "]" << endl;
-    cerr << _line.toUtf8().data() << endl;
-    cerr << endl;
-    cerr << _tree.toUtf8().data() << endl;
-    cerr << _previousTree.toUtf8().data() << endl;
-    cerr << endl;
-    exit(0);
+    setUpdatesEnabled(true);
 }
 
 void GraphWidget::debugGraphParser(
@@ -596,288 +1784,73 @@ void GraphWidget::debugGraphParser(
     cout << endl;
 }
 
-void GraphWidget::process(QList<QString> _cache)
+void GraphWidget::process(const QList<QString>& _cache)
 {
-    // cerr << "process start " << timestamp() << endl;
-
-    // reset local head
-    headVersion = NULL;
-
-    connectorStyle = mwin->getConnectorStyle();
-
-    clear();
-
-    mwin->getTagTree()->blockSignals(true);
-    mwin->getTagTree()->resetTagTree();
-
-    int linecount = 0;
-    int maxTreePatternLength = 0;
-
-    QVector<Version*> branchslots;
-    QVector<Version*> previousBranchslots;
-
-    // branchslots
-    // 0        : rootnode
-    // i%2 == 0 : version node
-    //            * version
-    //            |
-
-    QList<QString> swap_cache;
+    processBegin();
 
     foreach (const QString& line, _cache)
     {
-        swap_cache.push_front(line);
-        linecount++;
-        if (linecount > maxLines)
+        if (processAppend(line.toUtf8()) == false)
             break;
     }
 
-    // now root node is in the first line...
-    currentLines = linecount;
-
-    QString previousTree;
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    QRegularExpression treePattern("^([*\\\\/\\. |\\-_]*[*\\\\/\\.|\\-_]+)");
-#else
-    QRegExp treePattern("^([*\\\\/\\. |\\-_]*[*\\\\/\\.|\\-_]+)");
-#endif
-
-    int linenumber = 0;
-
-    foreach (const QString& line, swap_cache)
-    {
-        // get the tree pattern
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-        QRegularExpressionMatch m = treePattern.match(line);
-
-        if (!m.hasMatch())
-        {
-            cerr << "No --graph pattern contained in line " << linenumber << " : " << line.toUtf8().data() << endl;
-            continue;
-        }
-
-        int pos = m.capturedStart(1);
-
-        // get --graph tree pattern
-        int len = m.capturedLength(1);
-        QString tree = m.captured(1);
-#else
-        int pos = treePattern.indexIn(line, 0);
-
-        if (pos == -1)
-        {
-            cerr << "No --graph pattern contained in line " << linenumber << " : " << line.toUtf8().data() << endl;
-            continue;
-        }
-
-        // get --graph tree pattern
-        int len = treePattern.matchedLength();
-        QString tree = treePattern.cap(1);
-#endif
-
-        linenumber++;
-
-        // allocate space
-        if (previousTree.isEmpty())
-        {
-            branchslots = QVector<Version*>(tree.size());
-            maxTreePatternLength = len;
-        }
-        else if (maxTreePatternLength < len)
-        {
-            branchslots.resize(len + 1);
-            maxTreePatternLength = len;
-        }
-
-        // shift versions:
-        // use previousTree and tree to shift the versions
-        // stored in previousBranchslots to branchslots
-
-        // position of new version '*'
-        int newVersion = -1;
-
-        for (int i = 0; i < tree.size(); i++)
-        {
-            // current characters
-            // cll cl cm cr
-            // pll pl pm pr
-            char cll = (i > 1) ? tree.at(i - 2).toLatin1() : 0;
-            // char cl = (i > 0) ? tree.at(i - 1).toLatin1() : 0;
-            char cm = tree.at(i).toLatin1();
-            // char cr = (tree.size() > i + 1) ? tree.at(i + 1).toLatin1() : 0;
-            char pll = (i > 1 && previousTree.size() > i - 2) ? previousTree.at(i - 2).toLatin1() : 0;
-            char pl = ((previousTree.size() >= i) && (i > 0)) ? previousTree.at(i - 1).toLatin1() : 0;
-            char pm = (previousTree.size() > i) ? previousTree.at(i).toLatin1() : 0;
-            char pr = (previousTree.size() > i + 1) ? previousTree.at(i + 1).toLatin1() : 0;
-
-            // hope' all cases are covered
-            switch (cm)
-            {
-                case '|':
-                    if (pm == '|' || pm == '*' || pm == '/' || pm == '\\')
-                        branchslots[i] = previousBranchslots[i];
-                    else if (pl == '/')
-                        branchslots[i] = previousBranchslots[i - 1];
-                    else if (pr == '\\')
-                        branchslots[i] = previousBranchslots[i + 1];
-                    // else debugExit(cm,i,linenumber,tree,previousTree,line);
-                    break;
-                case '/':
-                    if (cll == '_')
-                        branchslots[i] = branchslots[i - 2];
-                    else if (pll == '/')
-                        branchslots[i] = previousBranchslots[i - 2];
-                    else if (pl == '|' || pl == '*' || pl == '/')
-                        branchslots[i] = previousBranchslots[i - 1];
-                    else if (pm == '\\' || pm == '|')
-                        branchslots[i] = previousBranchslots[i];
-                    // else debugExit(cm,i,linenumber,tree,previousTree,line);
-                    break;
-                case '_':
-                    if (cll == '_')
-                        branchslots[i] = branchslots[i - 2];
-                    else if (pll == '/')
-                        branchslots[i] = previousBranchslots[i - 2];
-                    // else debugExit(cm,i,linenumber,tree,previousTree,line);
-                    break;
-                case '\\':
-                    if (pm == '/')
-                        branchslots[i] = previousBranchslots[i];
-                    else if (pr == '|' || pr == '*' || pr == '\\')
-                        branchslots[i] = previousBranchslots[i + 1];
-                    // else debugExit(cm,i,linenumber,tree,previousTree,line);
-                    break;
-                case '.':
-                case '-':
-                    if (pr == '\\' || pr == ' ')
-                        branchslots[i] = previousBranchslots[i + 1];
-                    // else debugExit(cm,i,linenumber,tree,previousTree,line);
-                    break;
-                case '*':
-                    newVersion = i;
-                    break;
-                case ' ':
-                    break;
-                default:
-                    cerr << "Character " << cm << " not recognized." << endl;
-                    exit(0);
-                    break;
-            }
-        }
-
-        if (newVersion != -1)
-        {
-            // in each line at a maximum one new version '*' is contained
-            // this version has got one parent and n merge sources
-            Version* parent = NULL;
-            QList<Version*> mergeSources;
-
-            int i = newVersion;
-            // char cll = (i > 1) ? tree.at(i - 2).toLatin1() : 0;
-            // char cl = (i > 0) ? tree.at(i - 1).toLatin1() : 0;
-            // char cm = tree.at(i).toLatin1();
-            char cr = (tree.size() > i + 1) ? tree.at(i + 1).toLatin1() : 0;
-            // char pll = (i > 1 && previousTree.size() > i - 2) ? previousTree.at(i - 2).toLatin1() : 0;
-            char pl = ((previousTree.size() >= i) && (i > 0)) ? previousTree.at(i - 1).toLatin1() : 0;
-            char pm = (previousTree.size() > i) ? previousTree.at(i).toLatin1() : 0;
-            char pr = (previousTree.size() > i + 1) ? previousTree.at(i + 1).toLatin1() : 0;
-
-            if (pl == '/')
-                parent = previousBranchslots[i - 1];
-            else if (pm == '*' || pm == '|')
-                parent = previousBranchslots[i];
-            else if (pl == '\\')
-                parent = previousBranchslots[i + 1];
-
-            if (parent == NULL)
-                parent = rootVersion;
-
-            // collect merge sources
-            if (pl == '/' && parent != previousBranchslots[i - 1])
-                mergeSources.push_back(previousBranchslots[i - 1]);
-            if ((pm == '|' || pm == '*') && parent != previousBranchslots[i])
-                mergeSources.push_back(previousBranchslots[i]);
-            if (pr == '\\' && parent != previousBranchslots[i + 1])
-                mergeSources.push_back(previousBranchslots[i + 1]);
-            if (cr == '-')
-            {
-                int j = i + 1;
-                while (j < tree.size() && (tree.at(j) == '-' || tree.at(j) == '.'))
-                {
-                    Version* tmp = branchslots[j];
-                    if (tmp != NULL && tmp != parent)
-                        mergeSources.push_back(tmp);
-                    j++;
-                }
-            }
+    processEnd();
+}
 
-            // starting at pos+len the version information is contained
-            QString info = line.mid(pos + len);
+void GraphWidget::processBegin()
+{
+    refTips.clear();
+    // cerr << "process start " << timestamp() << endl;
 
-            // tokenize
-            QStringList parts = info.split(QChar('#'));
+    // reset local head
+    headVersion = NULL;
 
-            // abort, if too short...
-            if (parts.size() < 6)
-            {
-                cerr << "Error: Input too short " << line.toUtf8().data() << endl;
-                break;
-            }
+    connectorStyle = mwin->getConnectorStyle();
 
-            // create version node
-            Version* v = new Version(globalVersionInfo, changeableVersionInfo, this);
+    clear();
 
-            // if the key information has already been parsed, use it
-            QString hash = parts.at(1);
-            v->setKeyInformation(keyInformationCache.value(hash, QMap<QString, QStringList>()));
+    mwin->getTagTree()->blockSignals(true);
+    mwin->getTagTree()->resetTagTree();
 
-            // init or update
-            if (v->processGitLogInfo(info, parts))
-            {
-                keyInformationCache[hash] = v->getKeyInformation();
-            }
+    // each line is parsed when it is appended
+    delete (graphParser);
+    graphParser = new GraphLineParser(this, globalVersionInfo, changeableVersionInfo, rootVersion, commitStore, TagRules(mwin, changeableVersionInfo));
+    currentLines = 0;
+}
 
-            //
-            v->setIsFoldable(mwin->getVersionIsFoldable(v->getKeyInformation()));
+bool GraphWidget::processAppend(const QByteArray& _line)
+{
+    if (!graphParser->append(_line))
+        return false;
 
-            mwin->getTagTree()->addData(v);
+    currentLines++;
 
-            // main?
-            v->setIsMain(i == 0);
-            scene()->addItem(v);
+    return currentLines <= maxLines;
+}
 
-            Edge* e = new Edge (parent, v, this, false, parent == rootVersion);
-            scene()->addItem(e);
+void GraphWidget::processEnd()
+{
+    QList<QGraphicsItem*> items;
 
-            foreach(Version * merge, mergeSources)
-            {
-                Edge* mergeArrow = new Edge(merge, v, this, true, false);
+    graphParser->finish(items, headVersion);
+    delete (graphParser);
+    graphParser = NULL;
 
-                scene()->addItem(mergeArrow);
-            }
+    addGraphItems(items);
 
-            // replace parent
-            branchslots[i] = v;
-            // The last line contains the first version
-            // of the git log output.
-            headVersion = v;
-        }
+    rootVersion->collectFolderVersions(rootVersion, NULL);
+    layoutTree(rootVersion, mwin->getHorizontalSort());
 
-        //debugGraphParser(tree, branchslots);
-        previousTree = tree;
-        previousBranchslots = branchslots;
-        for (int i = 0; i < branchslots.size(); i++)
-        {
-            branchslots[i] = NULL;
-        }
-    }
+    processFinish();
+}
 
+void GraphWidget::processFinish(bool _resize)
+{
+    updateVersionIndex();
     localHeadVersion = gitlogSingle();
 
-    rootVersion->collectFolderVersions(rootVersion, NULL);
-    normalizeGraph();
-    setMinSize();
+    updateGraphGeometry();
+    setMinSize(_resize);
 
     mwin->getTagTree()->compress();
     mwin->getTagTree()->blockSignals(false);
@@ -890,7 +1863,27 @@ void GraphWidget::process(QList<QString> _cache)
     // cerr << "process end " << timestamp() << endl;
 }
 
-void GraphWidget::clear()
+void GraphWidget::addGraphItems(const QList<QGraphicsItem*>& _items)
+{
+    foreach (QGraphicsItem * it, _items)
+    {
+        scene()->addItem(it);
+
+        if (it->type() != QGraphicsItem::UserType + 1)
+            continue;
+
+        Version* v = dynamic_cast<Version*>(it);
+
+        if (!v)
+            continue;
+
+        // a GitLogWorker has created it with its copies of the lists
+        v->setVersionInfo(globalVersionInfo, changeableVersionInfo);
+        mwin->getTagTree()->addData(v);
+    }
+}
+
+void GraphWidget::clear(Version* _rootVersion)
 {
     if (rootVersion)
     {
@@ -909,7 +1902,16 @@ void GraphWidget::clear()
         delete (it);
     }
 
-    rootVersion = new Version(this);
+    versionIndex.clear();
+    versionIndexLengths.clear();
+
+    // the pending parents of a page refer to the former versions
+    cancelNextPage();
+    pendingParents.clear();
+    pendingParentsValid = false;
+    historyComplete = false;
+
+    rootVersion = _rootVersion ? _rootVersion : new Version(this);
     rootVersion->setPos(0, 0);
     scene()->addItem(rootVersion);
 
@@ -920,18 +1922,105 @@ void GraphWidget::clear()
 
 void GraphWidget::commitInfo(const Version* _v, QTextEdit* _tedi)
 {
-    // get data
-    QString cmd = "git -C " + localRepositoryPath + " log -1 " + _v->getHash();
-
     _tedi->clear();
-    QList<QString> cache;
 
-    execute_cmd(cmd.toUtf8().data(), cache, mwin->getPrintCmdToStdout());
-    foreach(const QString& str, cache)
+    // commits do not change, a known info is taken from the cache
+    QString* cached = commitInfoCache.object(_v->getHash());
+    QString text;
+
+    if (cached)
+        text = *cached;
+    else
     {
-        _tedi->insertPlainText(str);
+        catFile.readObjects(
+            QStringList(_v->getHash()),
+            [&text, _v](int, const QByteArray& _oid, const QByteArray& _type, const QByteArray& _content)
+            {
+                if (_type == "commit")
+                    text = formatCommitInfo(_v->getHash(), _oid, _content);
+            });
+
+        if (text.isEmpty())
+        {
+            QStringList cmd = QStringList() << "git" << "-C" << localRepositoryPath << "log" << "-1" << _v->getHash();
+            QList<QString> cache;
+
+            execute_cmd(cmd, cache, mwin->getPrintCmdToStdout());
+            foreach(const QString& str, cache)
+            {
+                text += str;
+            }
+        }
+
+        if (text.size())
+            commitInfoCache.insert(_v->getHash(), new QString(text), text.size());
     }
+
+    _tedi->insertPlainText(text);
     _tedi->moveCursor(QTextCursor::Start);
+
+    prefetchCommitInfo(_v);
+}
+
+void GraphWidget::prefetchCommitInfo(const Version* _v)
+{
+    // the next selection is likely a parent, a child or a folder member
+    QStringList hashes;
+
+    foreach(const Version* v, _v->getAdjacentVersions() + _v->getFolderVersions())
+    {
+        if (v->getHash().size()
+            && !commitInfoCache.contains(v->getHash())
+            && !hashes.contains(v->getHash()))
+            hashes.push_back(v->getHash());
+    }
+
+    if (hashes.isEmpty())
+        return;
+
+    // only the latest request is started after the running one
+    if (commitInfoPrefetcher)
+    {
+        commitInfoPending = hashes;
+        return;
+    }
+
+    commitInfoPrefetcher = new CommitInfoPrefetcher(&prefetchCatFile, localRepositoryPath, hashes, this);
+    connect(commitInfoPrefetcher, SIGNAL(finished()), this, SLOT(commitInfoPrefetched()));
+    commitInfoPrefetcher->start(QThread::LowestPriority);
+}
+
+void GraphWidget::commitInfoPrefetched()
+{
+    CommitInfoPrefetcher* prefetcher = dynamic_cast<CommitInfoPrefetcher*>(sender());
+
+    if (!prefetcher)
+        return;
+
+    prefetcher->deleteLater();
+    commitInfoPrefetcher = NULL;
+
+    // a result of the previous repository is dropped
+    if (prefetcher->getRepositoryPath() == localRepositoryPath)
+    {
+        const QMap<QString, QString>& infos = prefetcher->getInfos();
+
+        for (QMap<QString, QString>::const_iterator it = infos.constBegin(); it != infos.constEnd(); ++it)
+        {
+            commitInfoCache.insert(it.key(), new QString(it.value()), it.value().size());
+        }
+    }
+
+    if (commitInfoPending.size())
+    {
+        QStringList hashes = commitInfoPending;
+
+        commitInfoPending.clear();
+
+        commitInfoPrefetcher = new CommitInfoPrefetcher(&prefetchCatFile, localRepositoryPath, hashes, this);
+        connect(commitInfoPrefetcher, SIGNAL(finished()), this, SLOT(commitInfoPrefetched()));
+        commitInfoPrefetcher->start(QThread::LowestPriority);
+    }
 }
 
 void GraphWidget::fillCompareWidgetFromToInfo()
@@ -1195,25 +2284,32 @@ void GraphWidget::calculateGraphicsViewPosition()
 
 void GraphWidget::normalizeGraph()
 {
-    setBlockItemChanged(true);
-
-    int sort = mwin->getHorizontalSort();
+    layoutTree(rootVersion, mwin->getHorizontalSort());
+    updateGraphGeometry();
+}
 
-    if (sort == 1 || sort == 2)
+void GraphWidget::layoutTree(Version* _root, int _sort)
+{
+    if (_sort == 1 || _sort == 2)
     {
-        rootVersion->calculateWeightRecurse();
+        _root->calculateWeightRecurse();
     }
 
-    if (sort)
+    if (_sort)
     {
-        rootVersion->applyHorizontalSort(sort);
+        _root->applyHorizontalSort(_sort);
     }
 
-    // the following 5 commands create a collision free tree graph
-    rootVersion->simpleTreeGeometry(NULL);
-    rootVersion->centerParents(NULL);
-    rootVersion->shiftTree();
-    rootVersion->addShift(0);
+    // the following 4 commands create a collision free tree graph
+    _root->simpleTreeGeometry(NULL);
+    _root->centerParents(NULL);
+    _root->shiftTree();
+    _root->addShift(0);
+}
+
+void GraphWidget::updateGraphGeometry()
+{
+    setBlockItemChanged(true);
 
     // now the QGraphicsView geometry is calculated
     calculateGraphicsViewPosition();
@@ -1235,16 +2331,8 @@ void GraphWidget::normalizeGraph()
 
 void GraphWidget::adjustComments()
 {
-    foreach(QGraphicsItem * it, scene()->items())
-    {
-        if (it->type() != QGraphicsItem::UserType + 1)
-            continue;
-
-        Version* v = dynamic_cast<Version*>(it);
-
-        if (v)
-            v->updateCommentInformation(commentColumns, commentMaxlen);
-    }
+    // the comments are wrapped again when they are painted next
+    commitStore->setCommentProperties(commentColumns, commentMaxlen);
 }
 
 void GraphWidget::adjustAllEdges()
@@ -1277,16 +2365,57 @@ void GraphWidget::setBlockItemChanged(bool _val)
 
 Version* GraphWidget::findVersion(const QString& _hash)
 {
+    return versionIndex.value(ObjectId(_hash));
+}
+
+void GraphWidget::updateVersionIndex()
+{
+    versionIndex.clear();
+    versionIndexLengths.clear();
+
     foreach(QGraphicsItem * it, scene()->items())
     {
         if (it->type() != QGraphicsItem::UserType + 1)
             continue;
 
-        Version* v = dynamic_cast<Version*>(it);
+        addToVersionIndex(dynamic_cast<Version*>(it));
+    }
+}
+
+void GraphWidget::addToVersionIndex(Version* _v)
+{
+    // the root version has no hash
+    if (!_v || _v->getObjectId().isNull())
+        return;
+
+    versionIndex.insert(_v->getObjectId(), _v);
+    versionIndexLengths.insert(_v->getObjectId().size());
+}
+
+Version* GraphWidget::lookupLoaded(const QString& _oid) const
+{
+    Version* v = lookupVersion(_oid);
 
-        if (v && v->getHash() == _hash)
+    // skip a selected version restored without edges
+    return (v && v->numEdges()) ? v : NULL;
+}
+
+Version* GraphWidget::lookupVersion(const QString& _oid) const
+{
+    ObjectId oid(_oid);
+
+    if (oid.isNull())
+        return NULL;
+
+    // abbreviated hashes are unique prefixes of the object id
+    foreach(int length, versionIndexLengths)
+    {
+        Version* v = versionIndex.value(oid.left(length));
+
+        if (v)
             return v;
     }
+
     return NULL;
 }
 
@@ -1575,6 +2704,9 @@ void GraphWidget::setChangeableVersionInfo(const QStringList& _changeableVersion
     if (changeableVersionInfo != _changeableVersionInfo)
     {
         changeableVersionInfo = _changeableVersionInfo;
+
+        // versions have to be parsed again, no incremental refresh
+        refTips.clear();
         QGraphicsView::update();
     }
 }
@@ -1582,6 +2714,10 @@ void GraphWidget::setChangeableVersionInfo(const QStringList& _changeableVersion
 void GraphWidget::setLocalRepositoryPath(const QString& _dir)
 {
     localRepositoryPath = _dir;
+    catFile.setRepositoryPath(_dir, mwin->getPrintCmdToStdout());
+    prefetchCatFile.setRepositoryPath(_dir, mwin->getPrintCmdToStdout());
+    commitInfoCache.clear();
+    commitInfoPending.clear();
 }
 
 const QString& GraphWidget::getLocalRepositoryPath() const
@@ -1589,6 +2725,11 @@ const QString& GraphWidget::getLocalRepositoryPath() const
     return localRepositoryPath;
 }
 
+GitCatFile* GraphWidget::getCatFile()
+{
+    return &catFile;
+}
+
 void GraphWidget::preferencesUpdated(bool _forceUpdate)
 {
     bool updateAll = mwin->getXYFactor(xfactor, yfactor);
@@ -1970,17 +3111,7 @@ const QSet<Version*>& GraphWidget::getPredecessors() const
 
 Version* GraphWidget::getVersionByHash(const QString& _hash)
 {
-    foreach(QGraphicsItem * it, scene()->items())
-    {
-        if (it->type() != QGraphicsItem::UserType + 1)
-            continue;
-
-        Version* v = dynamic_cast<Version*>(it);
-
-        if (v && v->getHash() == _hash)
-            return v;
-    }
-    return NULL;
+    return versionIndex.value(ObjectId(_hash));
 }
 
 Version* GraphWidget::getSelectedVersion()
@@ -2003,8 +3134,8 @@ void GraphWidget::resetDiff()
     toVersion = NULL;
     fromToInfo->hide();
 
-    fromHashSave.clear();
-    toHashSave = QString();
+    fromIdSave.clear();
+    toIdSave = ObjectId();
 }
 
 bool GraphWidget::isFromToVersion(Version* _v) const
@@ -2027,18 +3158,24 @@ bool GraphWidget::getTopDownView() const
     return topDownView;
 }
 
+void GraphWidget::getCommentProperties(int& _columns, int& _maxlen) const
+{
+    _columns = commentColumns;
+    _maxlen = commentMaxlen;
+}
+
 void GraphWidget::saveImportantVersions()
 {
-    fromHashSave.clear();
+    fromIdSave.clear();
     foreach(Version * it, fromVersions)
     {
-        fromHashSave.push_back(it->getHash());
+        fromIdSave.push_back(it->getObjectId());
     }
-    toHashSave = toVersion ? toVersion->getHash() : QString();
+    toIdSave = toVersion ? toVersion->getObjectId() : ObjectId();
     fromVersions.clear();
     toVersion = NULL;
 
-    selectedVersionHash = selectedVersion ? selectedVersion->getHash() : QString();
+    selectedVersionId = selectedVersion ? selectedVersion->getObjectId() : ObjectId();
     selectedVersion = NULL;
 }
 
@@ -2048,43 +3185,40 @@ bool GraphWidget::restoreImportantVersions()
     toVersion = NULL;
     selectedVersion = NULL;
 
-    foreach(QGraphicsItem * it, scene()->items())
+    // the versions of the scene are indexed by processFinish()
+    foreach(const ObjectId& id, fromIdSave)
     {
-        if (it->type() != QGraphicsItem::UserType + 1)
-            continue;
-
-        Version* v = dynamic_cast<Version*>(it);
+        Version* v = versionIndex.value(id);
 
-        if (!v || v->getHash().isEmpty())
-            continue;
-
-        if (fromHashSave.contains(v->getHash()))
+        if (v)
         {
             fromVersions.insert(v);
             v->setMatched(true);
         }
-        if (toHashSave.isEmpty() == false && v->getHash() == toHashSave)
-        {
-            toVersion = v;
-            v->setMatched(true);
-        }
-        if (selectedVersionHash.isEmpty() == false && selectedVersionHash == v->getHash())
-        {
-            selectedVersion = v;
-            selectedVersion->setSelected(true);
-        }
     }
 
-    if (selectedVersion == NULL && selectedVersionHash.isEmpty() == false)
+    if (toIdSave.isNull() == false)
+    {
+        toVersion = versionIndex.value(toIdSave);
+        if (toVersion)
+            toVersion->setMatched(true);
+    }
+
+    if (selectedVersionId.isNull() == false)
     {
-        // previous selection, but no new node is matching
-        selectedVersion = findVersion(selectedVersionHash);
-        if (!selectedVersion)
+        selectedVersion = versionIndex.value(selectedVersionId);
+        if (selectedVersion)
+        {
+            selectedVersion->setSelected(true);
+        }
+        else
         {
-            selectedVersion = gitlogSingle(selectedVersionHash, true);
+            // previous selection, but no new node is matching
+            selectedVersion = gitlogSingle(selectedVersionId.toString(), true);
             selectedVersion->hide();
             scene()->addItem(selectedVersion);
-            if (fromHashSave.contains(selectedVersionHash))
+            addToVersionIndex(selectedVersion);
+            if (fromIdSave.contains(selectedVersionId))
             {
                 fromVersions.insert(selectedVersion);
             }
@@ -2092,8 +3226,8 @@ bool GraphWidget::restoreImportantVersions()
     }
 
     // everything restored ?
-    bool success = (fromVersions.size() == fromHashSave.size())
-        && (toHashSave.isEmpty() || toVersion != NULL);
+    bool success = (fromVersions.size() == fromIdSave.size())
+        && (toIdSave.isNull() || toVersion != NULL);
 
     if (success == false)
     {
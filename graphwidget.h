@@ -26,10 +26,16 @@
 #include <QList>
 #include <QRectF>
 #include <QTextEdit>
+#include <QCache>
 
 #include "fromtoinfo.h"
 #include "comparetree.h"
+#include "gitcatfile.h"
+#include "versionhashmap.h"
 
+class CommitStore;
+class GraphParser;
+class TagRules;
 class Version;
 
 class GraphWidget : public QGraphicsView
@@ -39,6 +45,7 @@ class GraphWidget : public QGraphicsView
 public:
     // Constructor
     GraphWidget(class MainWindow* parent = NULL);
+    virtual ~GraphWidget();
 
     // Test tree
     void test();
@@ -46,15 +53,34 @@ public:
     // Test load git log file
     void load(const QString& _path);
 
-    // Get real git log information of a local repository
+    // Get real git log information of a local repository.
+    // The graph is created by a GitLogWorker, loadFinished() is
+    // emitted when it has been taken over.
     void gitlog(bool _dirChanged = false);
+
+    // Reload the local repository. If only commits have been added
+    // since the last gitlog(), they are inserted into the current
+    // graph, otherwise gitlog() is called. git is run by a
+    // GitRefreshWorker, loadFinished() is emitted when it is done.
+    void refresh();
     Version* gitlogSingle(QString _hash = QString(), bool _create = false);
 
     // Get hashes of one file and markup versions
     void setGitLogFileConstraint(const QString& _fileConstraint = QString());
 
     // Create the graph from git log information
-    void process(QList<QString> _cache);
+    void process(const QList<QString>& _cache);
+
+    // Streaming interface used by process() and load():
+    // processAppend() parses one line of git log --graph output
+    // and returns false if maxLines is reached, processEnd() creates
+    // the edges and the graph, see GraphLineParser.
+    void processBegin();
+    bool processAppend(const QByteArray& _line);
+    void processEnd();
+
+    // Collision free tree geometry of Node, no QGraphicsItem is moved
+    static void layoutTree(Version* _root, int _sort);
 
     void forceUpdate();
 
@@ -73,7 +99,7 @@ public:
     void displayHits(Version* _v);
     void displayHits(const QList<Version*>& _hits, bool _unfold = true);
 
-    void clear();
+    void clear(Version* _rootVersion = NULL);
     void getMarkedupVersions(QList<Version*>& _markup, bool _selected = true);
     void resetMatches();
     void setMinSize(bool _resize = true);
@@ -85,6 +111,7 @@ public:
 
     void setLocalRepositoryPath(const QString& _dir);
     const QString& getLocalRepositoryPath() const;
+    GitCatFile* getCatFile();
 
     const class MainWindow* getMainWindow() const;
     void commitInfo(const Version* _v, QTextEdit* _tedi);
@@ -112,6 +139,7 @@ public:
     float getXFactor() const;
     float getYFactor() const;
     bool getTopDownView() const;
+    void getCommentProperties(int& _columns, int& _maxlen) const;
 
     Version* getLocalHeadVersion() const;
     void updateFromToInfo();
@@ -188,8 +216,103 @@ public slots:
     void adjustComments();
     void adjustAllEdges();
     void setBlockItemChanged(bool _val);
+    void cancelGitlog();
+
+protected slots:
+    void gitlogProgress(int _lines, int _expectedLines);
+    void gitlogPreviewReady();
+    void gitlogWorkerFinished();
+    void pathIndexWorkerFinished();
+    void refreshWorkerFinished();
+    void pageWorkerFinished();
+    void commitInfoPrefetched();
+
+    // load the next page of older versions
+    void loadNextPage();
+
+    // apply the changes since the snapshot has been written
+    void verifySnapshot();
+
+signals:
+    void loadFinished();
 
 protected:
+    void addGraphItems(const QList<QGraphicsItem*>& _items);
+
+    // replace the displayed graph by the versions and edges below _root,
+    // their information is kept in _store, the former store is deleted
+    void setGraph(Version* _root, const QList<QGraphicsItem*>& _items, Version* _headVersion, CommitStore* _store);
+
+    // show the GraphSnapshot of _key, false if there is none
+    bool restoreSnapshot(const QString& _key);
+
+    // load or build the PathIndex of the current ref tips
+    void updatePathIndex();
+
+    // fill the commit info cache for the neighbours of _v
+    void prefetchCommitInfo(const Version* _v);
+
+    // version next to the center of the view and its view position,
+    // restoreViewAnchor() scrolls it back to this position
+    Version* viewAnchor(QPoint& _viewPosition);
+    void restoreViewAnchor(Version* _anchor, const QPoint& _viewPosition);
+
+    /**
+     * \brief Start reading the next maxLines older versions by a
+     *        GitPageWorker, applyNextPage() attaches them when it
+     *        has finished.
+     *
+     * \return false, if there is no older version or a reload is needed
+     */
+    bool gitlogNextPage();
+    void cancelNextPage();
+
+    /**
+     * \brief Attach the older versions _lines below the loaded ones,
+     *        nothing loaded before is parsed again.
+     *
+     * \return false, if there is no older version or a reload is needed
+     */
+    bool applyNextPage(const QList<QString>& _lines);
+
+    // parents of the loaded versions which are not loaded,
+    // as read by _worker
+    void collectPendingParents(const class GitPageWorker* _worker);
+
+    // schedule the next page, if the root is close to the view
+    void checkNextPage();
+    virtual void scrollContentsBy(int _dx, int _dy);
+    void processFinish(bool _resize = true);
+    void updateGraphGeometry();
+
+    // git log --pretty format and revision arguments of the current settings
+    QString gitlogFormat() const;
+    QStringList gitlogRevisions() const;
+
+    // Start the check for commits added since the last load, they
+    // are inserted by applyIncremental() when it has finished.
+    // false, if the graph has to be reloaded by gitlog()
+    bool gitlogIncremental();
+    void cancelRefresh();
+
+    // Insert the new commits _lines into the graph and update the
+    // decorations by _decorationLines, _tips are the new ref tips.
+    // false, if the graph has to be reloaded by gitlog()
+    bool applyIncremental(const QStringList& _tips,
+                          const QList<QString>& _lines,
+                          const QList<QString>& _decorationLines);
+
+    // collect folders again and keep unfolded folders open,
+    // only in the subtree of _anchor, if set
+    void updateFolders(Version* _anchor = NULL);
+
+    // lowest loaded version whose subtree contains all _touched
+    // versions and all folders which may change by them
+    Version* layoutAnchor(const QList<Version*>& _touched) const;
+
+    // arrange the subtree of _anchor again without moving _anchor,
+    // false if it does not fit in between its neighbours any more
+    bool layoutSubtree(Version* _anchor);
     void focusFromTo(const QRectF& _from, const QRectF& _to);
     void animatedFocus(const QRectF& _from, const QRectF& _to);
     QRectF animatedFocus(const QRectF& _from, const QRectF& _to, double _morph);
@@ -208,14 +331,22 @@ protected:
     void fillCompareWidgetFromToInfo();
     Version* findVersion(const QString& _hash);
 
+    // index the versions of the scene by hash
+    void updateVersionIndex();
+    void addToVersionIndex(Version* _v);
+
+    // loaded version of the full or abbreviated object id _oid
+    Version* lookupVersion(const QString& _oid) const;
+
+    // as above, but only a version which is part of the graph
+    Version* lookupLoaded(const QString& _oid) const;
+
+    // object id of HEAD or the selected branch read from the refs,
+    // empty if the refs can not be read
+    QString resolveHeadRevision() const;
+
     // to debug the git log --graph parser...
     void debugGraphParser(const QString& _tree, const QVector<Version*>& _slots);
-    void debugExit(char _c,
-                   int _column,
-                   int _lineNumber,
-                   const QString& _tree,
-                   const QString& _previousTree,
-                   const QString& _line);
 
 private:
 
@@ -224,9 +355,9 @@ private:
     Version* toVersion;
     FromToInfo* fromToInfo;
 
-    // backup the hashes to restore after refresh
-    QStringList fromHashSave;
-    QString toHashSave;
+    // backup the object ids to restore after refresh
+    QList<ObjectId> fromIdSave;
+    ObjectId toIdSave;
 
     // root version node
     Version* rootVersion;
@@ -247,7 +378,9 @@ private:
     // argv
     QString localRepositoryPath;
     QString fileConstraint;
-    QSet<QString> fileConstraintHashes;
+
+    // object reader of localRepositoryPath
+    GitCatFile catFile;
 
     // preferences
     QColor backgroundColor;
@@ -264,6 +397,7 @@ private:
 
     int maxLines;
     int currentLines;
+
     bool shortHashes;
     bool reduceTree;
     bool topDownView;
@@ -276,10 +410,60 @@ private:
     int commentMaxlen;
 
     Version* selectedVersion;
-    QString selectedVersionHash;
+    ObjectId selectedVersionId;
+
+    // loaded versions by object id, and the hash lengths in use
+    VersionHashMap versionIndex;
+    QSet<int> versionIndexLengths;
 
-    //
-    QMap<QString, QMap<QString, QStringList> > keyInformationCache;
+    // background load started by gitlog()
+    class GitLogWorker* gitlogWorker;
+
+    // parser of process(), between processBegin() and processEnd()
+    GraphParser* graphParser;
+
+    // commits of the file constraint paths, built in the background
+    class PathIndex* pathIndex;
+    class PathIndexWorker* pathIndexWorker;
+
+    // background check of refresh()
+    class GitRefreshWorker* refreshWorker;
+
+    // background read of gitlogNextPage()
+    class GitPageWorker* pageWorker;
+
+    // commitInfo() texts by version hash, least recently used are
+    // dropped, the cost is the text length
+    QCache<QString, QString> commitInfoCache;
+
+    // own reader, the prefetch does not block catFile
+    GitCatFile prefetchCatFile;
+    class CommitInfoPrefetcher* commitInfoPrefetcher;
+    QStringList commitInfoPending;
+
+    // loaded versions waiting for a parent of an older page,
+    // by the object id of the parent, read once after a load and
+    // kept up to date by each page and refresh
+    struct PendingChild
+    {
+        PendingChild(Version* _version = NULL, bool _firstParent = false) :
+            version(_version), firstParent(_firstParent) {}
+
+        Version* version;
+        bool firstParent;
+    };
+    QHash<QString, QList<PendingChild> > pendingParents;
+    bool pendingParentsValid;
+    bool historyComplete;
+    bool nextPageScheduled;
+
+    // ref tips and revision arguments of the last load,
+    // used by gitlogIncremental()
+    QStringList refTips;
+    QStringList refTipsRevisions;
+
+    // information of the loaded commits, the versions keep their row
+    CommitStore* commitStore;
 
     QMap<QString, const QImage*> imageDB;
 };
@@ -32,7 +32,22 @@ HEADERS += \
         tagtree.h \
         branchtable.h \
         mimetable.h \
-        fromtoinfo.h 
+        fromtoinfo.h \
+        gitlogworker.h \
+        commitgraph.h \
+        gitcatfile.h \
+        graphsnapshot.h \
+        gittreemodel.h \
+        refdatabase.h \
+        pathindex.h \
+        statusengine.h \
+        commitinfo.h \
+        graphlinescanner.h \
+        versionhashmap.h \
+        commitstore.h \
+        objectid.h \
+        tagrules.h \
+        graphparser.h
 
 FORMS += gvtree_preferences.ui \
         gvtree_difftool.ui \
@@ -57,7 +72,22 @@ SOURCES += \
         tagtree.cpp \
         branchtable.cpp \
         mimetable.cpp \
-        fromtoinfo.cpp
+        fromtoinfo.cpp \
+        gitlogworker.cpp \
+        commitgraph.cpp \
+        gitcatfile.cpp \
+        graphsnapshot.cpp \
+        gittreemodel.cpp \
+        refdatabase.cpp \
+        pathindex.cpp \
+        statusengine.cpp \
+        commitinfo.cpp \
+        graphlinescanner.cpp \
+        versionhashmap.cpp \
+        commitstore.cpp \
+        objectid.cpp \
+        tagrules.cpp \
+        graphparser.cpp
 
 DISTFILES += $$SOURCEFILES \
   README \
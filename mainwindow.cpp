@@ -65,9 +65,9 @@ MainWindow::MainWindow(const QStringList& _argv) : QMainWindow(NULL), ctwin(NULL
     restoreColorSettings();
 
     // watchdog for the local repository directory
-    watcher = new QFileSystemWatcher();
-    connect(watcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(showRefreshButton(const QString&)));
-    connect(watcher, SIGNAL(fileChanged(const QString&)), this, SLOT(showRefreshButton(const QString&)));
+    statusEngine = new StatusEngine(this);
+    connect(statusEngine, SIGNAL(statusChanged()), this, SLOT(gitStatusChanged()));
+    connect(statusEngine, SIGNAL(refsChanged()), this, SLOT(showRefreshButton()));
 
     // remotes and all checkbox
     cbRemotes = new QCheckBox("--remotes");
@@ -107,6 +107,12 @@ MainWindow::MainWindow(const QStringList& _argv) : QMainWindow(NULL), ctwin(NULL
     pbRepositoryRefresh->hide();
     connect(pbRepositoryRefresh, SIGNAL(pressed()), this, SLOT(reloadCurrentRepository()));
 
+    // busy indicator while the graph is loaded in the background
+    loadProgress = new QProgressBar();
+    loadProgress->setRange(0, 0);
+    loadProgress->setMaximumWidth(100);
+    loadProgress->hide();
+
     // status bar
     statusBar()->show();
     statusBar()->addPermanentWidget(cbRemotes);
@@ -115,6 +121,7 @@ MainWindow::MainWindow(const QStringList& _argv) : QMainWindow(NULL), ctwin(NULL
     statusBar()->addPermanentWidget(pbRepositoryName);
     statusBar()->addPermanentWidget(pbFileConstraint);
     statusBar()->addPermanentWidget(pbRepositoryRefresh);
+    statusBar()->addPermanentWidget(loadProgress);
 
     // setup basics
     QWidget* centralWidget = new QWidget(this);
@@ -128,6 +135,7 @@ MainWindow::MainWindow(const QStringList& _argv) : QMainWindow(NULL), ctwin(NULL
     // setup central graph widget
     graphwidget = new GraphWidget(this);
     graphwidget->preferencesUpdated();
+    connect(graphwidget, SIGNAL(loadFinished()), this, SLOT(restoreVersionPosition()));
     centralLayout->addWidget(graphwidget);
     graphwidget->centerOn(graphwidget->mapToScene(QPoint(0, 0)));
     graphwidget->setFocus();
@@ -840,9 +848,7 @@ void MainWindow::removeFilter()
 
 void MainWindow::reloadCurrentRepository()
 {
-    QPoint restoreVersionPosition;
-    QTransform restoreTransform;
-    QString restoreVersionHash;
+    restoreVersionHash = QString();
 
     // if there is one selected version, keep it in place
     Version* restoreVersion = graphwidget->getSelectedVersion();
@@ -856,35 +862,15 @@ void MainWindow::reloadCurrentRepository()
         QPointF spos = restoreVersion->pos();
 
         // position in current view rectangle, left top corner is (0,0)
-        restoreVersionPosition = graphwidget->mapFromScene(spos);
+        restoreVersionViewPosition = graphwidget->mapFromScene(spos);
 
         // save transformation for scaling m11 m22
-        restoreTransform = graphwidget->transform();
+        restoreVersionTransform = graphwidget->transform();
     }
 
-    graphwidget->gitlog();
-
-    if (restoreVersion)
-    {
-        // get the version again
-        restoreVersion = graphwidget->getVersionByHash(restoreVersionHash);
-
-        if (restoreVersion)
-        {
-            // restore transformation
-            graphwidget->setTransform(QTransform(restoreTransform.m11(), 0, 0, restoreTransform.m22(), 0, 0));
-            // reset view to position (0,0)
-            graphwidget->horizontalScrollBar()->setValue(0);
-            graphwidget->verticalScrollBar()->setValue(0);
-
-            // Get the new position of the former selected version
-            // in view coordinates and get the difference to know
-            // how to shift the (invisible) scrollbars.
-            QPoint shift = graphwidget->mapFromScene(restoreVersion->pos()) - restoreVersionPosition;
-            graphwidget->horizontalScrollBar()->setValue(shift.x());
-            graphwidget->verticalScrollBar()->setValue(shift.y());
-        }
-    }
+    // the position is restored, when the graph has been loaded,
+    // new commits are inserted without a reload if possible
+    graphwidget->refresh();
 
     // if called from branchTable the refresh is blocked
     gvtree_branchtable.branchTable->refresh(repositoryPath);
@@ -892,6 +878,33 @@ void MainWindow::reloadCurrentRepository()
     pbRepositoryRefresh->hide();
 }
 
+void MainWindow::restoreVersionPosition()
+{
+    if (restoreVersionHash.isEmpty())
+        return;
+
+    // get the version again
+    Version* restoreVersion = graphwidget->getVersionByHash(restoreVersionHash);
+
+    restoreVersionHash = QString();
+
+    if (restoreVersion)
+    {
+        // restore transformation
+        graphwidget->setTransform(QTransform(restoreVersionTransform.m11(), 0, 0, restoreVersionTransform.m22(), 0, 0));
+        // reset view to position (0,0)
+        graphwidget->horizontalScrollBar()->setValue(0);
+        graphwidget->verticalScrollBar()->setValue(0);
+
+        // Get the new position of the former selected version
+        // in view coordinates and get the difference to know
+        // how to shift the (invisible) scrollbars.
+        QPoint shift = graphwidget->mapFromScene(restoreVersion->pos()) - restoreVersionViewPosition;
+        graphwidget->horizontalScrollBar()->setValue(shift.x());
+        graphwidget->verticalScrollBar()->setValue(shift.y());
+    }
+}
+
 void MainWindow::changeCssFilePath()
 {
     QFileDialog dialog(this, tr("Change Path to CSS Style Sheet File"), gvtree_preferences.pbCssPath->text());
@@ -1142,7 +1155,7 @@ TagTree* MainWindow::getTagTree() const
     return tagtree;
 }
 
-void MainWindow::getMimeTypeTools(const QString& _mimeType,
+void MainWindow::getMimeTypeTools(const QStringList& _mimeTypes,
                                   QString& _diff,
                                   QString& _edit)
 {
@@ -1150,13 +1163,18 @@ void MainWindow::getMimeTypeTools(const QString& _mimeType,
     _edit = QString("gvim %1");
 
     // if entry exists...
-    if (gvtree_preferences.mimeTypesTable->get(_mimeType, _diff, _edit))
-        return;
+    foreach(const QString& mimeType, _mimeTypes)
+    {
+        if (gvtree_preferences.mimeTypesTable->get(mimeType, _diff, _edit))
+            return;
+    }
+
+    QString newMimeType = _mimeTypes.size() ? _mimeTypes.front() : QString();
 
     QDialog* mimeTypeDialog = new QDialog;
 
     gvtree_difftool.setupUi(mimeTypeDialog);
-    gvtree_difftool.mimeType->setText(_mimeType);
+    gvtree_difftool.mimeType->setText(newMimeType);
     gvtree_difftool.leDiffTool->setText(_diff);
     gvtree_difftool.leEditTool->setText(_edit);
     connect(gvtree_difftool.pbOK, SIGNAL(clicked()), mimeTypeDialog, SLOT(accept()));
@@ -1165,7 +1183,7 @@ void MainWindow::getMimeTypeTools(const QString& _mimeType,
     if (mimeTypeDialog->exec() == QDialog::Accepted)
     {
         gvtree_preferences.mimeTypesTable->insert(
-            _mimeType,
+            newMimeType,
             gvtree_difftool.leDiffTool->text(),
             gvtree_difftool.leEditTool->text());
         _diff = gvtree_difftool.leDiffTool->text();
@@ -1478,40 +1496,26 @@ Ui_Dialog& MainWindow::getPreferences()
     return gvtree_preferences;
 }
 
-void MainWindow::showRefreshButton(const QString&)
+void MainWindow::showRefreshButton()
 {
     pbRepositoryRefresh->show();
 }
 
-void MainWindow::updateGitStatus(const QString& _repoPath)
+void MainWindow::gitStatusChanged()
 {
-// set watchdog
-    if (watcher)
-    {
-        if (watcher->directories().size())
-            watcher->removePaths(watcher->directories());
-        if (watcher->files().size())
-            watcher->removePaths(watcher->files());
-    }
-
-    gitstatus->clear();
-
-    // get data
-    QString cmd = "git -C " + _repoPath + " status";
-    QList<QString> cache;
-
-    execute_cmd(cmd.toUtf8().data(), cache, getPrintCmdToStdout());
-    foreach(const QString& str, cache)
-    {
-        gitstatus->insertPlainText(str);
-    }
+    gitstatus->setPlainText(statusEngine->getText());
     gitstatus->moveCursor(QTextCursor::Start);
+}
 
-    if (watcher)
-    {
-        QString gitpath = _repoPath + "/.git";
-        watcher->addPath(gitpath);
-    }
+void MainWindow::updateGitStatus(const QString& _repoPath)
+{
+    // the status is shown, when the background run has finished
+    statusEngine->setRepositoryPath(_repoPath, getPrintCmdToStdout());
+}
+
+const StatusEngine* MainWindow::getStatusEngine() const
+{
+    return statusEngine;
 }
 
 bool MainWindow::initCbCodecForCStrings(QString _default)
@@ -1550,15 +1554,15 @@ const QStringList& MainWindow::getVersionInfo() const
     return versionInfo;
 }
 
-bool MainWindow::getVersionIsFoldable(const QMap<QString, QStringList>& _keyinformation) const
+bool MainWindow::getVersionIsFoldable(const QStringList& _keys) const
 {
     bool foldable = true;
 
-    for (QMap<QString, QStringList>::const_iterator it = _keyinformation.begin();
-         it != _keyinformation.end() && foldable;
+    for (QStringList::const_iterator it = _keys.begin();
+         it != _keys.end() && foldable;
          it++)
     {
-        const TagPreference* tp = tagpreflist->getTagPreference(it.key());
+        const TagPreference* tp = tagpreflist->getTagPreference(*it);
         if (tp && tp->getFold() == 0 && tp->getVisibility() == true)
         {
             foldable = false;
@@ -1571,3 +1575,19 @@ GraphWidget* MainWindow::getGraphWidget()
 {
     return graphwidget;
 }
+
+void MainWindow::showLoadProgress(int _lines, int _expectedLines)
+{
+    // busy indicator, if the number of lines is not known
+    loadProgress->setRange(0, _expectedLines);
+    loadProgress->setValue(qMin(_lines, _expectedLines));
+    loadProgress->show();
+
+    statusBar()->showMessage(QString("Loading git log : %1 lines parsed").arg(_lines));
+}
+
+void MainWindow::hideLoadProgress()
+{
+    loadProgress->hide();
+    statusBar()->clearMessage();
+}
@@ -20,11 +20,11 @@
 
 #include <QAction>
 #include <QComboBox>
-#include <QFileSystemWatcher>
 #include <QLineEdit>
 #include <QMainWindow>
 #include <QMap>
 #include <QMenu>
+#include <QProgressBar>
 #include <QString>
 #include <QStringList>
 #include <QTextBrowser>
@@ -39,6 +39,7 @@
 #include "tagpreflist.h"
 #include "tagtree.h"
 #include "branchtable.h"
+#include "statusengine.h"
 #include "ui_gvtree_comparetree.h"
 #include "ui_gvtree_difftool.h"
 #include "ui_gvtree_help.h"
@@ -69,8 +70,9 @@ public:
     QDockWidget* getTagTreeDock();
     QString getSelectedBranch();
 
-    // dialog to store tools for a certain file type
-    void getMimeTypeTools(const QString& _mimeType,
+    // tools of the first of _mimeTypes in the mime type table,
+    // else a dialog stores tools for the first one
+    void getMimeTypeTools(const QStringList& _mimeTypes,
                           QString& _diff,
                           QString& _edit);
 
@@ -94,10 +96,18 @@ public:
     QString getTempPath() const;
     bool getPrintCmdToStdout() const;
     void getCommentProperties(int& _columns, int& _limit) const;
-    bool getVersionIsFoldable(const QMap<QString, QStringList>& _keyinformation) const;
+    bool getVersionIsFoldable(const QStringList& _keys) const;
 
     GraphWidget* getGraphWidget();
 
+    // git status of the local repository
+    const StatusEngine* getStatusEngine() const;
+
+    // busy indicator of a background load in the status bar
+    // _lines read and parsed of about _expectedLines, 0 if unknown
+    void showLoadProgress(int _lines, int _expectedLines = 0);
+    void hideLoadProgress();
+
     //
     Ui_Dialog& getPreferences();
 
@@ -107,7 +117,8 @@ public:
 public slots:
 
     // Watchdog if there are changes in the local repository
-    void showRefreshButton(const QString& _path);
+    void showRefreshButton();
+    void gitStatusChanged();
 
     // color preference changed
     void colorDialogBackground();
@@ -126,6 +137,7 @@ public slots:
 
     // File menu
     void reloadCurrentRepository();
+    void restoreVersionPosition();
     void resetCurrentRepository();
     void setGitLocalRepository();
     void quit();
@@ -250,12 +262,18 @@ private:
 
     QString repositoryPath;
     QString fileConstraintPath;
-    QFileSystemWatcher* watcher;
+    StatusEngine* statusEngine;
     QPushButton* pbRepositoryRefresh;
+    QProgressBar* loadProgress;
     QDockWidget* compareTreeDock;
     QDockWidget* tagTreeDock;
     QDockWidget* branchDock;
     QStringList versionInfo;
+
+    // keep the selected version in place after reload
+    QString restoreVersionHash;
+    QPoint restoreVersionViewPosition;
+    QTransform restoreVersionTransform;
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
     QRegularExpression foldNotRegExp;
 #else
@@ -103,7 +103,8 @@ bool MimeTable::get(const QString& _mimetype, QString& _diff, QString& _edit)
 {
     for (int i = 0; i < rowCount(); i++)
     {
-        if (item(i, 0)->text() == _mimetype)
+        // entries of former versions end with a newline
+        if (item(i, 0)->text().trimmed() == _mimetype)
         {
             _diff = item(i, 1)->text();
             _edit = item(i, 2)->text();
@@ -0,0 +1,142 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#include <string.h>
+
+#include "objectid.h"
+
+static inline int hexValue(char _c)
+{
+    if (_c >= '0' && _c <= '9')
+        return _c - '0';
+    if (_c >= 'a' && _c <= 'f')
+        return _c - 'a' + 10;
+    if (_c >= 'A' && _c <= 'F')
+        return _c - 'A' + 10;
+    return -1;
+}
+
+ObjectId::ObjectId() :
+    length(0)
+{
+    memset(bytes, 0, sizeof(bytes));
+}
+
+ObjectId::ObjectId(const char* _hex, int _size) :
+    length(0)
+{
+    memset(bytes, 0, sizeof(bytes));
+
+    if (_size <= 0 || _size > 2 * MaxBytes)
+        return;
+
+    for (int i = 0; i < _size; i++)
+    {
+        int value = hexValue(_hex[i]);
+
+        if (value < 0)
+        {
+            memset(bytes, 0, sizeof(bytes));
+            return;
+        }
+
+        bytes[i / 2] |= (i % 2) ? value : value << 4;
+    }
+
+    length = _size;
+}
+
+ObjectId::ObjectId(const QString& _hex) :
+    length(0)
+{
+    // a hash is plain ASCII
+    *this = ObjectId(_hex.toLatin1().constData(), _hex.size());
+}
+
+bool ObjectId::isNull() const
+{
+    return length == 0;
+}
+
+int ObjectId::size() const
+{
+    return length;
+}
+
+ObjectId ObjectId::left(int _size) const
+{
+    if (_size >= length)
+        return *this;
+
+    ObjectId result;
+
+    if (_size <= 0)
+        return result;
+
+    memcpy(result.bytes, bytes, (_size + 1) / 2);
+    if (_size % 2)
+        result.bytes[_size / 2] &= 0xf0;
+    result.length = _size;
+
+    return result;
+}
+
+QString ObjectId::toString() const
+{
+    static const char digits[] = "0123456789abcdef";
+    char hex[2 * MaxBytes];
+
+    for (int i = 0; i < length; i++)
+    {
+        hex[i] = digits[(i % 2) ? (bytes[i / 2] & 0xf) : (bytes[i / 2] >> 4)];
+    }
+
+    return QString::fromLatin1(hex, length);
+}
+
+quint32 ObjectId::hashValue() const
+{
+    // git ids are uniformly distributed, the first eight digits,
+    // an abbreviated hash has at least four
+    quint32 value = (quint32(bytes[0]) << 24) | (quint32(bytes[1]) << 16)
+        | (quint32(bytes[2]) << 8) | quint32(bytes[3]);
+
+    // right aligned like the digits of a short hash
+    if (length < 8)
+        value >>= 4 * (8 - length);
+
+    // spread short hashes over the upper bits
+    return value * 2654435761u;
+}
+
+bool ObjectId::operator==(const ObjectId& _other) const
+{
+    return length == _other.length && memcmp(bytes, _other.bytes, (length + 1) / 2) == 0;
+}
+
+bool ObjectId::operator!=(const ObjectId& _other) const
+{
+    return !(*this == _other);
+}
+
+bool ObjectId::operator<(const ObjectId& _other) const
+{
+    int cmp = memcmp(bytes, _other.bytes, MaxBytes);
+
+    return cmp < 0 || (cmp == 0 && length < _other.length);
+}
@@ -0,0 +1,75 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#ifndef __OBJECTID_H__
+#define __OBJECTID_H__
+
+#include <QString>
+#include <QtGlobal>
+
+/**
+ * \brief Binary git object id, 20 bytes of SHA-1 or 32 bytes of
+ *        SHA-256. An abbreviated hash keeps its number of hex digits,
+ *        so it may end with half a byte. The hex string is only
+ *        created for display and git commands.
+ */
+class ObjectId
+{
+public:
+    enum { MaxBytes = 32 };
+
+    // null id
+    ObjectId();
+
+    // id of the _size hex digits at _hex, null if there are too many
+    // or if a character is no hex digit
+    ObjectId(const char* _hex, int _size);
+    explicit ObjectId(const QString& _hex);
+
+    bool isNull() const;
+
+    // number of hex digits
+    int size() const;
+
+    // the first _size hex digits
+    ObjectId left(int _size) const;
+
+    QString toString() const;
+
+    // the leading digits spread over 32 bits, see VersionHashMap
+    quint32 hashValue() const;
+
+    bool operator==(const ObjectId& _other) const;
+    bool operator!=(const ObjectId& _other) const;
+
+    // byte order, an abbreviated id is less than the ids it is a
+    // prefix of and greater than all other lesser ids
+    bool operator<(const ObjectId& _other) const;
+
+private:
+    // unused bytes and the last half byte of an odd size are zero
+    quint8 bytes[MaxBytes];
+    quint8 length;
+};
+
+inline uint qHash(const ObjectId& _id)
+{
+    return _id.hashValue();
+}
+
+#endif
@@ -0,0 +1,442 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+
+#include "execute_cmd.h"
+#include "graphsnapshot.h"
+#include "pathindex.h"
+
+static const quint32 pathIndexMagic = 0x47565049; // "GVPI"
+static const quint32 pathIndexVersion = 2;
+
+void PathIndex::CommitSet::add(quint32 _commit)
+{
+    // commits added by an update
+    if (bitmap.size())
+    {
+        if (int(_commit) >= bitmap.size())
+            bitmap.resize(_commit + 1);
+        bitmap.setBit(_commit);
+        return;
+    }
+
+    // several files of one folder in the same commit
+    if (commits.isEmpty() || commits.last() != _commit)
+        commits.push_back(_commit);
+}
+
+void PathIndex::CommitSet::squeeze(quint32 _commits)
+{
+    if (bitmap.size())
+    {
+        bitmap.resize(_commits);
+        return;
+    }
+
+    // a bitmap has one bit per commit, a number 32
+    if (quint64(commits.size()) * 32 <= _commits)
+    {
+        commits.squeeze();
+        return;
+    }
+
+    bitmap = QBitArray(_commits);
+
+    foreach (quint32 c, commits)
+    {
+        bitmap.setBit(c);
+    }
+    commits = QVector<quint32>();
+}
+
+bool PathIndex::CommitSet::contains(quint32 _commit) const
+{
+    if (bitmap.size())
+        return int(_commit) < bitmap.size() && bitmap.testBit(_commit);
+
+    return std::binary_search(commits.constBegin(), commits.constEnd(), _commit);
+}
+
+QDataStream& operator<<(QDataStream& _out, const PathIndex::CommitSet& _set)
+{
+    return _out << _set.commits << _set.bitmap;
+}
+
+QDataStream& operator>>(QDataStream& _in, PathIndex::CommitSet& _set)
+{
+    return _in >> _set.commits >> _set.bitmap;
+}
+
+PathIndex::PathIndex(const QString& _repositoryPath, const QStringList& _revisions) :
+    repositoryPath(_repositoryPath),
+    revisions(_revisions),
+    commits(0)
+{
+}
+
+QString PathIndex::key() const
+{
+    return (QStringList(repositoryPath) << revisions).join(QChar('\n'));
+}
+
+bool PathIndex::build(const QStringList& _refTips, bool _log, const std::function<bool()>& _interrupted)
+{
+    refTips.clear();
+    commits = 0;
+    commitIds.clear();
+    commitNumbers.clear();
+    paths.clear();
+
+    // both sides of a rename are listed like for git log -- <path>
+    QStringList cmd = QStringList()
+        << "git" << "-C" << repositoryPath << "-c" << "core.quotePath=false"
+        << "log" << "--name-only" << "--no-renames" << "--format=%x01%H"
+        << revisions;
+
+    if (!read(cmd, QByteArray(), _log, _interrupted))
+        return false;
+
+    refTips = _refTips;
+
+    return true;
+}
+
+bool PathIndex::update(const QStringList& _refTips, bool _log, const std::function<bool()>& _interrupted)
+{
+    if (refTips.isEmpty())
+        return build(_refTips, _log, _interrupted);
+
+    // the former ref tips are passed by stdin, there may be too
+    // many of them for the command line
+    QByteArray input;
+
+    foreach (const QString& tip, refTips)
+    {
+        input += '^' + tip.toLatin1() + '\n';
+    }
+
+    QStringList cmd = QStringList()
+        << "git" << "-C" << repositoryPath << "-c" << "core.quotePath=false"
+        << "log" << "--name-only" << "--no-renames" << "--format=%x01%H"
+        << revisions << "--stdin";
+
+    if (!read(cmd, input, _log, _interrupted))
+        return false;
+
+    refTips = _refTips;
+
+    return true;
+}
+
+bool PathIndex::read(const QStringList& _cmd, const QByteArray& _input, bool _log, const std::function<bool()>& _interrupted)
+{
+    // the new commits are numbered after the indexed ones, so the
+    // numbers of each path stay in ascending order
+    QVector<QPair<ObjectId, quint32> > added;
+    quint32 next = commits;
+    bool commit = false;
+
+    // "\x01<hash>" followed by the changed paths
+    int status = execute_cmd(
+        _cmd,
+        _input,
+        [&](const QByteArray& _line)
+        {
+            if (_interrupted())
+                return false;
+
+            int len = _line.size();
+
+            if (len && _line.at(len - 1) == '\n')
+                len--;
+
+            if (len == 0)
+                return true;
+
+            if (_line.at(0) == '\x01')
+            {
+                added.push_back(qMakePair(ObjectId(_line.constData() + 1, len - 1), next));
+                next++;
+                commit = true;
+                return true;
+            }
+
+            if (!commit)
+                return true;
+
+            // the file and all its folders
+            QString path = QString::fromUtf8(_line.constData(), len);
+
+            for (;;)
+            {
+                paths[path].add(next - 1);
+
+                int sep = path.lastIndexOf(QChar('/'));
+
+                if (sep == -1)
+                    break;
+
+                path.truncate(sep);
+            }
+
+            return true;
+        },
+        _log);
+
+    if (_interrupted() || status != 0)
+        return false;
+
+    commits = next;
+
+    for (QHash<QString, CommitSet>::iterator it = paths.begin(); it != paths.end(); ++it)
+    {
+        it.value().squeeze(commits);
+    }
+
+    // merge the new commits into the sorted ids, a commit which
+    // is already indexed keeps its number
+    std::sort(added.begin(), added.end());
+
+    QVector<ObjectId> ids;
+    QVector<quint32> numbers;
+    int i = 0;
+    int j = 0;
+
+    ids.reserve(commitIds.size() + added.size());
+    numbers.reserve(commitIds.size() + added.size());
+
+    while (i < commitIds.size() || j < added.size())
+    {
+        if (j == added.size() || (i < commitIds.size() && !(added.at(j).first < commitIds.at(i))))
+        {
+            if (j < added.size() && added.at(j).first == commitIds.at(i))
+                j++;
+
+            ids.push_back(commitIds.at(i));
+            numbers.push_back(commitNumbers.at(i));
+            i++;
+        }
+        else
+        {
+            ids.push_back(added.at(j).first);
+            numbers.push_back(added.at(j).second);
+            j++;
+        }
+    }
+
+    commitIds = ids;
+    commitNumbers = numbers;
+
+    return true;
+}
+
+bool PathIndex::save() const
+{
+    QString path = GraphSnapshot::cacheFileName("pathindex", key());
+
+    if (path.isEmpty() || !QDir().mkpath(QFileInfo(path).path()))
+        return false;
+
+    QString tmpPath = path + "." + QString::number(getpid());
+    QFile file(tmpPath);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+        return false;
+
+    QDataStream out(&file);
+
+    // the object ids as they are in memory, the file
+    // is read on the same machine only
+    out << pathIndexMagic << pathIndexVersion << key() << refTips
+        << commits << quint32(commitIds.size());
+    out.writeRawData(reinterpret_cast<const char*>(commitIds.constData()), commitIds.size() * sizeof(ObjectId));
+    out << commitNumbers << paths;
+
+    file.close();
+
+    if (out.status() != QDataStream::Ok
+        || rename(QFile::encodeName(tmpPath).data(), QFile::encodeName(path).data()) != 0)
+    {
+        file.remove();
+        return false;
+    }
+
+    return true;
+}
+
+bool PathIndex::load()
+{
+    QFile file(GraphSnapshot::cacheFileName("pathindex", key()));
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    QDataStream in(&file);
+    quint32 magic = 0;
+    quint32 version = 0;
+    QString fileKey;
+    quint32 size = 0;
+
+    in >> magic >> version;
+
+    if (magic != pathIndexMagic || version != pathIndexVersion)
+        return false;
+
+    in >> fileKey;
+
+    if (fileKey != key())
+        return false;
+
+    in >> refTips >> commits >> size;
+
+    // not more ids than there are bytes
+    if (in.status() != QDataStream::Ok || qint64(size) * qint64(sizeof(ObjectId)) > file.size())
+    {
+        refTips.clear();
+        return false;
+    }
+
+    commitIds.resize(size);
+
+    if (in.readRawData(reinterpret_cast<char*>(commitIds.data()), size * sizeof(ObjectId)) != int(size * sizeof(ObjectId)))
+        in.setStatus(QDataStream::ReadPastEnd);
+
+    in >> commitNumbers >> paths;
+
+    if (in.status() != QDataStream::Ok || commitNumbers.size() != commitIds.size())
+    {
+        refTips.clear();
+        commits = 0;
+        commitIds.clear();
+        commitNumbers.clear();
+        paths.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool PathIndex::isSameKey(const PathIndex& _other) const
+{
+    return key() == _other.key();
+}
+
+bool PathIndex::isValid(const QStringList& _revisions, const QStringList& _refTips) const
+{
+    return _refTips.isEmpty() == false && revisions == _revisions && refTips == _refTips;
+}
+
+const QStringList& PathIndex::getRefTips() const
+{
+    return refTips;
+}
+
+const PathIndex::CommitSet* PathIndex::find(const QString& _path) const
+{
+    QString path = _path;
+
+    while (path.endsWith(QChar('/')))
+        path.chop(1);
+
+    QHash<QString, CommitSet>::const_iterator it = paths.constFind(path);
+
+    return (it == paths.constEnd()) ? NULL : &it.value();
+}
+
+int PathIndex::commitNumber(const ObjectId& _id) const
+{
+    if (_id.isNull())
+        return -1;
+
+    // an abbreviated id is just before the ids it is a prefix of
+    QVector<ObjectId>::const_iterator it = std::lower_bound(commitIds.constBegin(), commitIds.constEnd(), _id);
+
+    if (it == commitIds.constEnd() || it->left(_id.size()) != _id)
+        return -1;
+
+    return int(commitNumbers.at(it - commitIds.constBegin()));
+}
+
+PathIndexWorker::PathIndexWorker(const QString& _repositoryPath,
+                                 const QStringList& _revisions,
+                                 const QStringList& _refTips,
+                                 const PathIndex* _base,
+                                 bool _log,
+                                 QObject* _parent) :
+    QThread(_parent),
+    index(new PathIndex(_repositoryPath, _revisions)),
+    refTips(_refTips),
+    based(false),
+    log(_log),
+    complete(false)
+{
+    // the containers are implicitly shared, the copy is cheap
+    if (_base && _base->isSameKey(*index))
+    {
+        *index = *_base;
+        based = true;
+    }
+}
+
+PathIndexWorker::~PathIndexWorker()
+{
+    delete (index);
+}
+
+void PathIndexWorker::run()
+{
+    std::function<bool()> interrupted = [this]() { return isInterruptionRequested(); };
+
+    if (!based)
+        index->load();
+
+    if (index->getRefTips() == refTips)
+    {
+        complete = true;
+        return;
+    }
+
+    // e.g. a former ref tip does not exist any more
+    if (!index->update(refTips, log, interrupted))
+    {
+        if (interrupted() || !index->build(refTips, log, interrupted))
+            return;
+    }
+
+    index->save();
+    complete = true;
+}
+
+PathIndex* PathIndexWorker::takeIndex()
+{
+    if (!complete || isInterruptionRequested())
+        return NULL;
+
+    PathIndex* result = index;
+
+    index = NULL;
+    complete = false;
+
+    return result;
+}
@@ -0,0 +1,166 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __PATHINDEX_H__
+#define __PATHINDEX_H__
+
+#include <QBitArray>
+#include <QDataStream>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include <functional>
+
+#include "objectid.h"
+
+/**
+ * \brief Index of the commits which have changed a path, for each
+ *        file and each of its parent folders. Commits are numbered
+ *        in the order they have been indexed, the commits of a path
+ *        are a set of these numbers.
+ *        The index is built from one git log --name-only run of the
+ *        loaded revisions and is valid for the ref tips it has been
+ *        built for. When the ref tips move, only the commits which
+ *        are new since then are added. Like git log -- <path>
+ *        without further options, renames are not followed. Merges
+ *        are not listed, as they do not change a path themselves.
+ */
+class PathIndex
+{
+public:
+    /**
+     * \brief Set of commit numbers. Sorted numbers for paths with
+     *        few commits, a bitmap of all commits for the others.
+     */
+    class CommitSet
+    {
+    public:
+        // numbers are added in ascending order
+        void add(quint32 _commit);
+        // choose the smaller representation for _commits commits,
+        // a bitmap stays one
+        void squeeze(quint32 _commits);
+        bool contains(quint32 _commit) const;
+
+        friend QDataStream& operator<<(QDataStream& _out, const CommitSet& _set);
+        friend QDataStream& operator>>(QDataStream& _in, CommitSet& _set);
+
+    private:
+        QVector<quint32> commits;
+        QBitArray bitmap;
+    };
+
+    PathIndex(const QString& _repositoryPath, const QStringList& _revisions);
+
+    /**
+     * \brief Run git log --name-only for the ref tips _refTips and
+     *        index its output.
+     *
+     * \return false, if _interrupted returned true or git failed
+     */
+    bool build(const QStringList& _refTips, bool _log, const std::function<bool()>& _interrupted);
+
+    /**
+     * \brief Add the commits of the ref tips _refTips which are not
+     *        reachable from the ref tips of the index, i.e. git log
+     *        --name-only old..new. Commits which are not reachable any
+     *        more stay, their numbers are never asked for.
+     *
+     * \return false, if _interrupted returned true or git failed,
+     *         e.g. if an old ref tip does not exist any more
+     */
+    bool update(const QStringList& _refTips, bool _log, const std::function<bool()>& _interrupted);
+
+    // save to or load from the user cache directory, the
+    // index of any ref tips is loaded
+    bool save() const;
+    bool load();
+
+    // same repository and revisions
+    bool isSameKey(const PathIndex& _other) const;
+
+    // built for these revisions and ref tips
+    bool isValid(const QStringList& _revisions, const QStringList& _refTips) const;
+    const QStringList& getRefTips() const;
+
+    /**
+     * \brief Commits of _path, a file or a folder.
+     *
+     * \return NULL, if _path has never been changed
+     */
+    const CommitSet* find(const QString& _path) const;
+
+    // number of the commit _id (full or abbreviated), -1 if unknown
+    int commitNumber(const ObjectId& _id) const;
+
+protected:
+    QString key() const;
+
+    // index the output of _cmd, _input is passed to its stdin
+    bool read(const QStringList& _cmd, const QByteArray& _input, bool _log, const std::function<bool()>& _interrupted);
+
+private:
+    QString repositoryPath;
+    QStringList revisions;
+    QStringList refTips;
+
+    // next commit number
+    quint32 commits;
+
+    // object ids sorted for commitNumber() and their numbers
+    QVector<ObjectId> commitIds;
+    QVector<quint32> commitNumbers;
+
+    QHash<QString, CommitSet> paths;
+};
+
+/**
+ * \brief Updates a copy of the current index _base or the saved
+ *        index, or builds a PathIndex in a background thread.
+ *        A changed index is saved for the next start.
+ */
+class PathIndexWorker : public QThread
+{
+public:
+    PathIndexWorker(const QString& _repositoryPath,
+                    const QStringList& _revisions,
+                    const QStringList& _refTips,
+                    const PathIndex* _base,
+                    bool _log,
+                    QObject* _parent = NULL);
+    virtual ~PathIndexWorker();
+
+    // NULL, if the build has failed or been interrupted
+    PathIndex* takeIndex();
+
+protected:
+    virtual void run();
+
+private:
+    PathIndex* index;
+    QStringList refTips;
+
+    // a copy of the current index, else it is loaded
+    bool based;
+    bool log;
+    bool complete;
+};
+
+#endif
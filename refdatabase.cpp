@@ -0,0 +1,173 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+
+#include "refdatabase.h"
+
+// object id or "ref: <target>" of a ref file
+static QString readRefFile(const QString& _path)
+{
+    QFile file(_path);
+
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+
+    return QString::fromUtf8(file.readLine()).trimmed();
+}
+
+bool RefDatabase::gitDirectories(const QString& _repositoryPath, QString& _gitDir, QString& _commonDir)
+{
+    QString gitDir = _repositoryPath + "/.git";
+    QFileInfo fi(gitDir);
+
+    // worktree or submodule: .git is a file "gitdir: <path>"
+    if (fi.isFile())
+    {
+        QString line = readRefFile(gitDir);
+
+        if (!line.startsWith("gitdir:"))
+            return false;
+
+        gitDir = line.mid(7).trimmed();
+
+        if (QDir::isRelativePath(gitDir))
+            gitDir = _repositoryPath + "/" + gitDir;
+    }
+    else if (!fi.isDir())
+        return false;
+
+    _gitDir = gitDir;
+    _commonDir = gitDir;
+
+    // linked worktrees share refs and objects of the main repository
+    QString common = readRefFile(gitDir + "/commondir");
+
+    if (common.size())
+        _commonDir = QDir::isRelativePath(common) ? gitDir + "/" + common : common;
+
+    return true;
+}
+
+bool RefDatabase::read(const QString& _repositoryPath, const QStringList& _prefixes)
+{
+    refs.clear();
+    head.clear();
+
+    QString gitDir;
+    QString commonDir;
+
+    if (!gitDirectories(_repositoryPath, gitDir, commonDir))
+        return false;
+
+    // refs are not stored in files
+    if (QFileInfo(commonDir + "/reftable").exists())
+        return false;
+
+    if (!readPackedRefs(commonDir + "/packed-refs", _prefixes))
+        return false;
+
+    foreach (const QString& prefix, _prefixes)
+    {
+        readLooseRefs(commonDir, prefix);
+    }
+
+    // HEAD belongs to the worktree
+    head = readRefFile(gitDir + "/HEAD");
+
+    if (head.startsWith("ref:"))
+        head = head.mid(4).trimmed();
+
+    return head.isEmpty() == false;
+}
+
+bool RefDatabase::readPackedRefs(const QString& _path, const QStringList& _prefixes)
+{
+    QFile file(_path);
+
+    // no packed refs
+    if (!file.exists())
+        return true;
+
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    // "<oid> <refname>", comments start with '#',
+    // peeled tags with '^'
+    while (!file.atEnd())
+    {
+        QByteArray line = file.readLine().trimmed();
+
+        if (line.isEmpty() || line.at(0) == '#' || line.at(0) == '^')
+            continue;
+
+        int sep = line.indexOf(' ');
+
+        if (sep == -1)
+            continue;
+
+        QString name = QString::fromUtf8(line.mid(sep + 1));
+
+        foreach (const QString& prefix, _prefixes)
+        {
+            if (name.startsWith(prefix))
+            {
+                refs.insert(name, QString::fromLatin1(line.left(sep)));
+                break;
+            }
+        }
+    }
+
+    return true;
+}
+
+void RefDatabase::readLooseRefs(const QString& _commonDir, const QString& _prefix)
+{
+    QDirIterator it(_commonDir + "/" + _prefix, QDir::Files | QDir::Hidden, QDirIterator::Subdirectories);
+    int skip = _commonDir.size() + 1;
+
+    while (it.hasNext())
+    {
+        QString path = it.next();
+
+        // lock files of a running git command
+        if (path.endsWith(".lock"))
+            continue;
+
+        QString value = readRefFile(path);
+
+        // symbolic refs like refs/remotes/origin/HEAD
+        if (value.isEmpty() || value.startsWith("ref:"))
+            continue;
+
+        refs.insert(path.mid(skip), value);
+    }
+}
+
+const QMap<QString, QString>& RefDatabase::getRefs() const
+{
+    return refs;
+}
+
+const QString& RefDatabase::getHead() const
+{
+    return head;
+}
@@ -0,0 +1,64 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __REFDATABASE_H__
+#define __REFDATABASE_H__
+
+#include <QMap>
+#include <QString>
+#include <QStringList>
+
+/**
+ * \brief Reader of the git refs of a repository: packed-refs and
+ *        loose refs below refs/, loose refs win. Symbolic refs like
+ *        refs/remotes/origin/HEAD are skipped, HEAD is read separately.
+ *        Repositories with the reftable format are not supported,
+ *        read() returns false then.
+ */
+class RefDatabase
+{
+public:
+    /**
+     * \brief Resolve the git directory of the worktree _repositoryPath
+     *        (.git file of worktrees and submodules) and the common
+     *        directory with the refs and objects shared by all worktrees.
+     */
+    static bool gitDirectories(const QString& _repositoryPath, QString& _gitDir, QString& _commonDir);
+
+    /**
+     * \brief Read all refs below _prefixes, e.g. "refs/heads/".
+     *
+     * \return false, if the refs could not be read
+     */
+    bool read(const QString& _repositoryPath, const QStringList& _prefixes);
+
+    // full ref name to object id
+    const QMap<QString, QString>& getRefs() const;
+
+    // "refs/heads/<branch>" or the object id of a detached HEAD
+    const QString& getHead() const;
+
+protected:
+    void readLooseRefs(const QString& _commonDir, const QString& _prefix);
+    bool readPackedRefs(const QString& _path, const QStringList& _prefixes);
+
+private:
+    QMap<QString, QString> refs;
+    QString head;
+};
+
+#endif
@@ -0,0 +1,579 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include <iostream>
+#include <errno.h>
+#include <unistd.h>
+
+#include <QFile>
+#include <QSet>
+#include <QSocketNotifier>
+
+#ifdef Q_OS_LINUX
+#include <sys/inotify.h>
+#endif
+
+#include "execute_cmd.h"
+#include "refdatabase.h"
+#include "statusengine.h"
+
+using namespace std;
+
+// quiet time before git status runs, and the maximum delay during a burst
+static const int statusDebounce = 300;
+static const int statusMaxDelay = 1000;
+
+// git status label of the index or worktree status _c
+static QString statusLabel(char _c)
+{
+    switch (_c)
+    {
+    case 'M':
+        return "modified:   ";
+    case 'T':
+        return "typechange: ";
+    case 'A':
+        return "new file:   ";
+    case 'D':
+        return "deleted:    ";
+    case 'R':
+        return "renamed:    ";
+    case 'C':
+        return "copied:     ";
+    }
+    return QString();
+}
+
+// text after the first _fields space separated fields
+static QString fieldsTail(const QByteArray& _entry, int _fields)
+{
+    int pos = 0;
+
+    for (int i = 0; i < _fields && pos != -1; i++)
+    {
+        pos = _entry.indexOf(' ', pos);
+
+        if (pos != -1)
+            pos++;
+    }
+
+    return (pos == -1) ? QString() : QString::fromUtf8(_entry.mid(pos));
+}
+
+StatusWorker::StatusWorker(const QString& _repositoryPath, bool _listDirectories, bool _log) :
+    QThread(NULL),
+    repositoryPath(_repositoryPath),
+    listDirectories(_listDirectories),
+    log(_log),
+    success(false)
+{
+}
+
+bool StatusWorker::readOutput(const QStringList& _argv, QByteArray& _output)
+{
+    int status = execute_cmd(
+        _argv,
+        [this, &_output](const QByteArray& _line)
+        {
+            if (isInterruptionRequested())
+                return false;
+
+            _output.append(_line);
+            return true;
+        },
+        log);
+
+    return status == 0 && !isInterruptionRequested();
+}
+
+void StatusWorker::run()
+{
+    QStringList git = QStringList()
+        << "git" << "-C" << repositoryPath << "--no-optional-locks";
+
+    // the index is not refreshed, the write would trigger the next run
+    QByteArray output;
+
+    if (!readOutput(QStringList(git) << "status" << "--porcelain=v2" << "-z" << "--branch", output))
+        return;
+
+    parseStatus(output);
+
+    RefDatabase refDatabase;
+
+    if (refDatabase.read(repositoryPath, QStringList("refs/")))
+    {
+        refState = refDatabase.getHead();
+
+        for (QMap<QString, QString>::const_iterator it = refDatabase.getRefs().constBegin();
+             it != refDatabase.getRefs().constEnd();
+             ++it)
+        {
+            refState += "\n" + it.key() + " " + it.value();
+        }
+    }
+
+    if (listDirectories)
+    {
+        QByteArray files;
+
+        if (!readOutput(QStringList(git) << "ls-files" << "-z", files))
+            return;
+
+        QSet<QString> folders;
+
+        folders.insert(QString());
+
+        foreach (const QByteArray& file, files.split('\0'))
+        {
+            int sep = file.lastIndexOf('/');
+
+            if (sep != -1)
+                folders.insert(QString::fromUtf8(file.left(sep)));
+        }
+
+        directories = folders.values();
+    }
+
+    success = true;
+}
+
+void StatusWorker::parseStatus(const QByteArray& _output)
+{
+    QString branch;
+    QString oid;
+    QString upstream;
+    int ahead = 0;
+    int behind = 0;
+
+    QStringList staged;
+    QStringList unstaged;
+    QStringList unmerged;
+    QStringList untracked;
+
+    QList<QByteArray> entries = _output.split('\0');
+
+    for (int i = 0; i < entries.size(); i++)
+    {
+        const QByteArray& entry = entries.at(i);
+
+        if (entry.size() < 2)
+            continue;
+
+        switch (entry.at(0))
+        {
+        case '#':
+            if (entry.startsWith("# branch.head "))
+                branch = QString::fromUtf8(entry.mid(14));
+            else if (entry.startsWith("# branch.oid "))
+                oid = QString::fromLatin1(entry.mid(13));
+            else if (entry.startsWith("# branch.upstream "))
+                upstream = QString::fromUtf8(entry.mid(18));
+            else if (entry.startsWith("# branch.ab "))
+            {
+                QList<QByteArray> ab = entry.mid(11).split(' ');
+
+                if (ab.size() == 2)
+                {
+                    ahead = ab.at(0).mid(1).toInt();
+                    behind = ab.at(1).mid(1).toInt();
+                }
+            }
+            break;
+
+        case '1':
+        case '2':
+        {
+            // "1 XY sub mH mI mW hH hI path", a rename has
+            // a score field and the original path as next entry
+            if (entry.size() < 4)
+                break;
+
+            char x = entry.at(2);
+            char y = entry.at(3);
+            QString path = fieldsTail(entry, entry.at(0) == '1' ? 8 : 9);
+            QString label = path;
+
+            if (entry.at(0) == '2' && i + 1 < entries.size())
+                label = QString::fromUtf8(entries.at(++i)) + " -> " + path;
+
+            if (x != '.')
+            {
+                staged << "\t" + statusLabel(x) + label;
+                stagedFiles << path;
+            }
+            if (y != '.')
+            {
+                unstaged << "\t" + statusLabel(y) + path;
+                modifiedFiles << path;
+            }
+            break;
+        }
+
+        case 'u':
+        {
+            QString path = fieldsTail(entry, 10);
+
+            unmerged << "\tunmerged:   " + path;
+            stagedFiles << path;
+            modifiedFiles << path;
+            break;
+        }
+
+        case '?':
+            untracked << "\t" + QString::fromUtf8(entry.mid(2));
+            break;
+        }
+    }
+
+    QStringList lines;
+
+    if (branch == "(detached)")
+        lines << "HEAD detached at " + oid.left(7);
+    else
+        lines << "On branch " + branch;
+
+    if (upstream.size())
+    {
+        QString name = "'" + upstream + "'";
+
+        if (ahead && behind)
+            lines << "Your branch and " + name + " have diverged,"
+                  << "and have " + QString::number(ahead) + " and " + QString::number(behind)
+                + " different commits each, respectively.";
+        else if (ahead)
+            lines << "Your branch is ahead of " + name + " by " + QString::number(ahead)
+                + (ahead == 1 ? " commit." : " commits.");
+        else if (behind)
+            lines << "Your branch is behind " + name + " by " + QString::number(behind)
+                + (behind == 1 ? " commit." : " commits.");
+        else
+            lines << "Your branch is up to date with " + name + ".";
+    }
+
+    if (staged.size())
+        lines << QString() << "Changes to be committed:" << staged;
+    if (unmerged.size())
+        lines << QString() << "Unmerged paths:" << unmerged;
+    if (unstaged.size())
+        lines << QString() << "Changes not staged for commit:" << unstaged;
+    if (untracked.size())
+        lines << QString() << "Untracked files:" << untracked;
+
+    if (staged.isEmpty() && unmerged.isEmpty() && unstaged.isEmpty())
+    {
+        lines << QString()
+              << (untracked.isEmpty() ? "nothing to commit, working tree clean"
+                  : "nothing added to commit but untracked files present");
+    }
+
+    text = lines.join(QChar('\n')) + "\n";
+}
+
+bool StatusWorker::getSuccess() const
+{
+    return success;
+}
+
+const QString& StatusWorker::getText() const
+{
+    return text;
+}
+
+const QStringList& StatusWorker::getStagedFiles() const
+{
+    return stagedFiles;
+}
+
+const QStringList& StatusWorker::getModifiedFiles() const
+{
+    return modifiedFiles;
+}
+
+const QString& StatusWorker::getRefState() const
+{
+    return refState;
+}
+
+bool StatusWorker::getListDirectories() const
+{
+    return listDirectories;
+}
+
+const QStringList& StatusWorker::getDirectories() const
+{
+    return directories;
+}
+
+StatusEngine::StatusEngine(QObject* _parent) :
+    QObject(_parent),
+    log(false),
+    worker(NULL),
+    listDirectories(false),
+    rerun(false),
+    changed(false),
+    valid(false),
+    inotifyFd(-1),
+    inotifyNotifier(NULL)
+{
+    debounceTimer.setSingleShot(true);
+    connect(&debounceTimer, SIGNAL(timeout()), this, SLOT(update()));
+    connect(&gitDirWatcher, SIGNAL(directoryChanged(const QString&)), this, SLOT(pathChanged(const QString&)));
+    connect(&gitDirWatcher, SIGNAL(fileChanged(const QString&)), this, SLOT(pathChanged(const QString&)));
+}
+
+StatusEngine::~StatusEngine()
+{
+    if (worker)
+    {
+        worker->requestInterruption();
+        worker->wait();
+        delete (worker);
+    }
+
+    stopWatching();
+}
+
+void StatusEngine::setRepositoryPath(const QString& _repositoryPath, bool _log)
+{
+    log = _log;
+
+    if (_repositoryPath == repositoryPath)
+    {
+        update();
+        return;
+    }
+
+    repositoryPath = _repositoryPath;
+
+    text.clear();
+    stagedFiles.clear();
+    modifiedFiles.clear();
+    refState.clear();
+    valid = false;
+
+    stopWatching();
+
+    if (gitDirWatcher.directories().size())
+        gitDirWatcher.removePaths(gitDirWatcher.directories());
+    if (gitDirWatcher.files().size())
+        gitDirWatcher.removePaths(gitDirWatcher.files());
+
+    // index and HEAD of the worktree, refs of the common directory
+    QString gitDir;
+    QString commonDir;
+
+    if (RefDatabase::gitDirectories(repositoryPath, gitDir, commonDir))
+    {
+        gitDirWatcher.addPath(gitDir);
+        if (commonDir != gitDir)
+            gitDirWatcher.addPath(commonDir);
+    }
+
+    // a running worker belongs to the previous repository,
+    // workerFinished() drops its result
+    if (worker)
+    {
+        worker->requestInterruption();
+        worker = NULL;
+    }
+
+    listDirectories = true;
+    update();
+}
+
+void StatusEngine::update()
+{
+    debounceTimer.stop();
+
+    if (repositoryPath.isEmpty())
+        return;
+
+    if (worker)
+    {
+        rerun = true;
+        return;
+    }
+
+    changed = false;
+
+    worker = new StatusWorker(repositoryPath, listDirectories, log);
+    listDirectories = false;
+    connect(worker, SIGNAL(finished()), this, SLOT(workerFinished()));
+    worker->start();
+}
+
+void StatusEngine::workerFinished()
+{
+    StatusWorker* finished = dynamic_cast<StatusWorker*>(sender());
+
+    if (!finished)
+        return;
+
+    finished->deleteLater();
+
+    if (finished != worker)
+        return;
+
+    worker = NULL;
+
+    if (finished->getSuccess())
+    {
+        if (finished->getListDirectories())
+            startWatching(finished->getDirectories());
+
+        bool statusDiffers = !valid
+            || text != finished->getText()
+            || stagedFiles != finished->getStagedFiles()
+            || modifiedFiles != finished->getModifiedFiles();
+        bool refsDiffer = valid && refState != finished->getRefState();
+
+        text = finished->getText();
+        stagedFiles = finished->getStagedFiles();
+        modifiedFiles = finished->getModifiedFiles();
+        refState = finished->getRefState();
+        valid = true;
+
+        if (statusDiffers)
+            emit statusChanged();
+        if (refsDiffer)
+            emit refsChanged();
+
+        // e.g. a branch has been reset without a change of the
+        // git directory itself
+        if (refsDiffer && !finished->getListDirectories())
+        {
+            listDirectories = true;
+            rerun = true;
+        }
+    }
+    else if (finished->getListDirectories())
+    {
+        // try again with the next run
+        listDirectories = true;
+    }
+
+    if (rerun)
+    {
+        rerun = false;
+        update();
+    }
+}
+
+void StatusEngine::pathChanged(const QString&)
+{
+    // index or HEAD, tracked files may have been added or removed
+    listDirectories = true;
+    scheduleUpdate();
+}
+
+void StatusEngine::scheduleUpdate()
+{
+    changed = true;
+
+    if (!debounceTimer.isActive())
+        burst.start();
+
+    // the window is extended by each event, up to the maximum delay
+    if (!debounceTimer.isActive() || burst.elapsed() < statusMaxDelay)
+        debounceTimer.start(statusDebounce);
+}
+
+void StatusEngine::startWatching(const QStringList& _directories)
+{
+    stopWatching();
+
+#ifdef Q_OS_LINUX
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (inotifyFd == -1)
+        return;
+
+    uint32_t mask = IN_CLOSE_WRITE | IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ATTRIB | IN_ONLYDIR;
+
+    foreach (const QString& dir, _directories)
+    {
+        QString path = dir.isEmpty() ? repositoryPath : repositoryPath + "/" + dir;
+
+        if (inotify_add_watch(inotifyFd, QFile::encodeName(path).data(), mask) != -1)
+            continue;
+
+        // folder of a deleted file
+        if (errno == ENOENT || errno == ENOTDIR)
+            continue;
+
+        // e.g. fs.inotify.max_user_watches exceeded
+        cerr << "Error: Could not watch " << path.toUtf8().data() << endl;
+        stopWatching();
+        return;
+    }
+
+    inotifyNotifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(inotifyNotifier, SIGNAL(activated(int)), this, SLOT(inotifyActivated()));
+#else
+    Q_UNUSED(_directories);
+#endif
+}
+
+void StatusEngine::stopWatching()
+{
+    delete (inotifyNotifier);
+    inotifyNotifier = NULL;
+
+    if (inotifyFd != -1)
+    {
+        close(inotifyFd);
+        inotifyFd = -1;
+    }
+}
+
+void StatusEngine::inotifyActivated()
+{
+    // the events themselves are not needed, git status
+    // finds out what has changed
+    char buffer[4096];
+    bool events = false;
+
+    while (inotifyFd != -1 && read(inotifyFd, buffer, sizeof(buffer)) > 0)
+    {
+        events = true;
+    }
+
+    if (events)
+        scheduleUpdate();
+}
+
+const QString& StatusEngine::getText() const
+{
+    return text;
+}
+
+const QStringList& StatusEngine::getStagedFiles() const
+{
+    return stagedFiles;
+}
+
+const QStringList& StatusEngine::getModifiedFiles() const
+{
+    return modifiedFiles;
+}
+
+bool StatusEngine::isCurrent() const
+{
+    // without the worktree watch an edit is not noticed
+    return valid && inotifyNotifier != NULL && !changed && worker == NULL;
+}
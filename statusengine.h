@@ -0,0 +1,160 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __STATUSENGINE_H__
+#define __STATUSENGINE_H__
+
+#include <QElapsedTimer>
+#include <QFileSystemWatcher>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QTimer>
+
+class QSocketNotifier;
+
+/**
+ * \brief Runs git status --porcelain=v2 in a background thread and
+ *        formats the result like git status. Optionally the folders
+ *        of all tracked files are listed for the worktree watch.
+ */
+class StatusWorker : public QThread
+{
+public:
+    StatusWorker(const QString& _repositoryPath, bool _listDirectories, bool _log);
+
+    // false, if git status failed or has been interrupted
+    bool getSuccess() const;
+    const QString& getText() const;
+    const QStringList& getStagedFiles() const;
+    const QStringList& getModifiedFiles() const;
+
+    // HEAD and all refs, changes if the graph is outdated
+    const QString& getRefState() const;
+
+    // folders of the tracked files relative to the repository,
+    // only if _listDirectories has been set
+    bool getListDirectories() const;
+    const QStringList& getDirectories() const;
+
+protected:
+    virtual void run();
+
+    // parse the NUL separated entries of git status --porcelain=v2 -z
+    void parseStatus(const QByteArray& _output);
+
+    // output of _argv, false if it failed or has been interrupted
+    bool readOutput(const QStringList& _argv, QByteArray& _output);
+
+private:
+    QString repositoryPath;
+    bool listDirectories;
+    bool log;
+    bool success;
+
+    QString text;
+    QStringList stagedFiles;
+    QStringList modifiedFiles;
+    QString refState;
+    QStringList directories;
+};
+
+/**
+ * \brief Keeps the git status of a repository up to date without
+ *        blocking the GUI.
+ *        Changes of the git directory and, on Linux, of the folders of
+ *        the tracked files (inotify) are coalesced: git status runs
+ *        once the events have paused for a short time, during a
+ *        continuous burst at least every second.
+ *        The staged and modified files of the last run are current as
+ *        long as no event has arrived since, e.g. for the local diffs.
+ */
+class StatusEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+    StatusEngine(QObject* _parent = NULL);
+    virtual ~StatusEngine();
+
+    // watch _repositoryPath, an unchanged path only runs update()
+    void setRepositoryPath(const QString& _repositoryPath, bool _log = false);
+
+    // git status formatted like the git status command
+    const QString& getText() const;
+
+    // like git diff --cached --name-only and git ls-files -m
+    const QStringList& getStagedFiles() const;
+    const QStringList& getModifiedFiles() const;
+
+    // true, if the file lists reflect the worktree
+    bool isCurrent() const;
+
+public slots:
+    // run git status now
+    void update();
+
+signals:
+    // the status text or the file lists have changed
+    void statusChanged();
+
+    // HEAD or a ref has changed after the first run
+    void refsChanged();
+
+protected slots:
+    void pathChanged(const QString& _path);
+    void inotifyActivated();
+    void workerFinished();
+
+protected:
+    // start or extend the debounce window
+    void scheduleUpdate();
+
+    void startWatching(const QStringList& _directories);
+    void stopWatching();
+
+private:
+    QString repositoryPath;
+    bool log;
+
+    QFileSystemWatcher gitDirWatcher;
+    QTimer debounceTimer;
+    QElapsedTimer burst;
+
+    StatusWorker* worker;
+
+    // the tracked files may have changed, e.g. by a new index or HEAD,
+    // the next run lists their folders for the worktree watch again
+    bool listDirectories;
+    bool rerun;
+
+    // an event has arrived since the last run has been started
+    bool changed;
+    bool valid;
+
+    QString text;
+    QStringList stagedFiles;
+    QStringList modifiedFiles;
+    QString refState;
+
+    // inotify watch of the worktree folders
+    int inotifyFd;
+    QSocketNotifier* inotifyNotifier;
+};
+
+#endif
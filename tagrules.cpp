@@ -0,0 +1,129 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#include "commitstore.h"
+#include "mainwindow.h"
+#include "tagpreference.h"
+#include "tagrules.h"
+
+TagRules::TagRules()
+{
+}
+
+TagRules::TagRules(const MainWindow* _mainWindow, const QStringList& _changeableVersionInfo)
+{
+    if (!_mainWindow)
+        return;
+
+    QStringList scanItems (QStringList()
+                           << QString("HEAD")
+                           << _changeableVersionInfo
+                           << QString("Other Tags"));
+
+    foreach(const QString& it, scanItems)
+    {
+        const TagPreference* tp = _mainWindow->getTagPreference(it);
+
+        if (tp)
+        {
+            Rule rule;
+
+            rule.key = it;
+            rule.regExp = tp->getRegExp();
+            rules.push_back(rule);
+        }
+    }
+
+    foreach(const QString& it, _mainWindow->getVersionInfo())
+    {
+        const TagPreference* tp = _mainWindow->getTagPreference(it);
+
+        if (tp && tp->getFold() == 0 && tp->getVisibility() == true)
+            unfoldableKeys.insert(it);
+    }
+}
+
+void TagRules::parse(const QString& _tagInfo, CommitStore* _store, int _row) const
+{
+    int cstart = _tagInfo.indexOf(QChar('(')) + 1;
+    int cend = _tagInfo.indexOf(QChar(')'));
+
+    if (cstart >= 0 && cend >= 0)
+    {
+        QStringList matches = _tagInfo.mid(cstart, cend - cstart).split(',');
+        QStringList tags;
+
+        foreach (const QString& str, matches)
+        {
+            tags << str.trimmed();
+        }
+
+        foreach(const Rule& rule, rules)
+        {
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+            foreach (const QString& str, tags)
+            {
+                QRegularExpressionMatch m = rule.regExp.match(str);
+
+                if (m.hasMatch())
+                {
+                    _store->addTag(_row, rule.key, m.captured(1));
+                    tags.removeOne(str);
+                }
+            }
+#else
+            QRegExp r = rule.regExp;
+            foreach (const QString& str, tags)
+            {
+                if (r.indexIn(str, 0) != -1)
+                {
+                    _store->addTag(_row, rule.key, r.cap(1));
+                    tags.removeOne(str);
+                }
+            }
+#endif
+        }
+    }
+}
+
+bool TagRules::isFoldable(const QStringList& _keys) const
+{
+    foreach(const QString& key, _keys)
+    {
+        if (unfoldableKeys.contains(key))
+            return false;
+    }
+    return true;
+}
+
+QString TagRules::toString() const
+{
+    QStringList result;
+
+    foreach(const Rule& rule, rules)
+    {
+        result.push_back(rule.key + "=" + rule.regExp.pattern());
+    }
+
+    QStringList keys = unfoldableKeys.values();
+
+    keys.sort();
+    result << keys;
+
+    return result.join(QChar('\n'));
+}
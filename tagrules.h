@@ -0,0 +1,79 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+
+#ifndef __TAGRULES_H__
+#define __TAGRULES_H__
+
+#include <QList>
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+#include <QRegularExpression>
+#else
+#include <QRegExp>
+#endif
+#include <QSet>
+#include <QString>
+#include <QStringList>
+
+class CommitStore;
+class MainWindow;
+
+/**
+ * \brief Copy of the tag preferences which are needed to parse the
+ *        git log information: the patterns of the tags and the keys
+ *        which keep a version from being folded.
+ *        The tag preferences are widgets of the GUI thread, so a
+ *        GitLogWorker parses against a copy taken when it is created.
+ */
+class TagRules
+{
+public:
+    TagRules();
+
+    // copy the preferences of _mainWindow, in the GUI thread only
+    TagRules(const MainWindow* _mainWindow, const QStringList& _changeableVersionInfo);
+
+    /**
+     * \brief The %d information _tagInfo of the git log output is
+     *        analyzed for the tag patterns, the matches are added
+     *        to _row of _store.
+     */
+    void parse(const QString& _tagInfo, CommitStore* _store, int _row) const;
+
+    // false, if one of _keys is visible and must not be folded
+    bool isFoldable(const QStringList& _keys) const;
+
+    // the rules as text, e.g. as part of a cache key
+    QString toString() const;
+
+private:
+    struct Rule
+    {
+        QString key;
+#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
+        QRegularExpression regExp;
+#else
+        QRegExp regExp;
+#endif
+    };
+
+    // HEAD, the changeable tag preferences and "Other Tags"
+    QList<Rule> rules;
+    QSet<QString> unfoldableKeys;
+};
+
+#endif
@@ -19,6 +19,7 @@
 
 #include <QMenu>
 #include <QAction>
+#include "commitstore.h"
 #include "tagtree.h"
 #include "mainwindow.h"
 #include "graphwidget.h"
@@ -87,7 +88,7 @@ void TagTree::updateSearchResult(QList<Version*>& _matches)
         c1->setIcon(QIcon(":/images/gvt_dot.png"));
         c1->setEditable(false);
 
-        QStandardItem* c2 = new QStandardItem(v->getKeyInformation().find("Commit Date").value().join(" "));
+        QStandardItem* c2 = new QStandardItem(v->getCommitDateString());
 
         c2->setData(QVariant::fromValue(VersionPointer(v)), Qt::UserRole + 1);
         c2->setEditable(false);
@@ -145,22 +146,15 @@ void TagTree::compress(QStandardItem* _p)
 
 void TagTree::addData(const Version* _v)
 {
-    QString timestamp;
+    QString timestamp = _v->getCommitDateString();
 
-    QMap<QString, QStringList>::const_iterator dt = _v->getKeyInformation().find("Commit Date");
-
-    if (dt != _v->getKeyInformation().end())
-        timestamp = dt.value().join(" ");
-
-    for (QMap<QString, QStringList>::const_iterator it = _v->getKeyInformation().begin();
-         it != _v->getKeyInformation().end();
-         it++)
+    foreach(const QString& info, _v->getInformationKeys())
     {
-        QString key = it.key();
-        if (key == "_input" || key == "Comment")
+        QString key = info;
+        if (key == CommitStore::inputKey || key == CommitStore::commentKey)
             continue;
-        else if (key == "CommentRaw")
-            key = "Comment";
+        else if (key == CommitStore::commentRawKey)
+            key = CommitStore::commentKey;
 
         // level 1 : taginfo key
         QStandardItem* p = findOrInsert(root, key, false);
@@ -183,7 +177,7 @@ void TagTree::addData(const Version* _v)
         }
         else
         {
-            foreach(const QString &val, it.value())
+            foreach(const QString &val, _v->getInformation(info))
             {
                 insertLeaf(findOrInsert(p, val), timestamp, _v);
             }
@@ -24,10 +24,12 @@
 #include <iostream>
 #include <algorithm>
 
+#include "commitstore.h"
 #include "edge.h"
 #include "version.h"
 #include "graphwidget.h"
 #include "tagpreference.h"
+#include "tagrules.h"
 #include "mainwindow.h"
 
 QStringList Version::dummy;
@@ -36,9 +38,11 @@ Version::Version(GraphWidget* _graphWidget, QGraphicsItem* _parent) :
     QGraphicsItem(_parent),
     Node(),
     graph(_graphWidget),
-    globalVersionInfo(dummy),
-    changeableVersionInfo(dummy),
+    globalVersionInfo(&dummy),
+    changeableVersionInfo(&dummy),
     matched(false),
+    store(NULL),
+    row(-1),
     folded(false),
     foldable(true),
     rootnode(true),
@@ -48,8 +52,7 @@ Version::Version(GraphWidget* _graphWidget, QGraphicsItem* _parent) :
     main(false),
     fileConstraint(false),
     selected(false),
-    weight(0),
-    commitDate(0)
+    weight(0)
 {
     // flags
     setFlag(ItemSendsGeometryChanges);
@@ -64,9 +67,11 @@ Version::Version(const QStringList& _globalVersionInfo,
     QGraphicsItem(_parent),
     Node(),
     graph(_graphWidget),
-    globalVersionInfo(_globalVersionInfo),
-    changeableVersionInfo(_changeableVersionInfo),
+    globalVersionInfo(&_globalVersionInfo),
+    changeableVersionInfo(&_changeableVersionInfo),
     matched(false),
+    store(NULL),
+    row(-1),
     folded(true),
     foldable(true),
     rootnode(false),
@@ -76,8 +81,7 @@ Version::Version(const QStringList& _globalVersionInfo,
     main(false),
     fileConstraint(false),
     selected(false),
-    weight(0),
-    commitDate(0)
+    weight(0)
 {
     // flags
     setFlag(ItemIsMovable);
@@ -145,6 +149,24 @@ QList<Version*> Version::getNeighbourBox()
     return result;
 }
 
+QList<Version*> Version::getAdjacentVersions() const
+{
+    QList<Version*> result;
+
+    foreach (const Edge * edge, edgeList)
+    {
+        Version* v =
+            dynamic_cast<Version*>(
+                this == edge->sourceVersion()
+                ? edge->destVersion() : edge->sourceVersion());
+
+        if (v)
+            result.push_back(v);
+    }
+
+    return result;
+}
+
 void Version::setBlockItemChanged(bool _val)
 {
     blockItemChanged = _val;
@@ -157,8 +179,8 @@ bool Version::getBlockItemChanged() const
 
 void Version::setSelected(bool _val)
 {
-    QApplication::clipboard()->setText(_val ? hash : QString(), QClipboard::Selection);
-    QApplication::clipboard()->setText(_val ? hash : QString(), QClipboard::Clipboard);
+    QApplication::clipboard()->setText(_val ? getHash() : QString(), QClipboard::Selection);
+    QApplication::clipboard()->setText(_val ? getHash() : QString(), QClipboard::Clipboard);
 
     if (selected != _val)
     {
@@ -193,6 +215,12 @@ void Version::addOutEdge(Edge* _edge)
     }
 }
 
+void Version::removeEdge(Edge* _edge)
+{
+    edgeList.removeAll(_edge);
+    outEdges.removeAll(_edge);
+}
+
 QRectF Version::boundingRect() const
 {
     return localBoundingBox;
@@ -264,13 +292,13 @@ void Version::paint(QPainter* _painter, const QStyleOptionGraphicsItem* _option,
 
         foreach(const QString& info, graph->getMainWindow()->getVersionInfo())
         {
-            if (globalVersionInfo.contains(info)
+            if (globalVersionInfo->contains(info)
                 || localVersionInfo.contains(info))
             {
-                QMap<QString, QStringList>::const_iterator kit = keyInformation.find(info);
-                if (kit != keyInformation.end())
+                QStringList values = getInformation(info);
+                if (!values.isEmpty())
                 {
-                    drawTextBox(info, kit.value(), height, lod, _painter, textborder);
+                    drawTextBox(info, values, height, lod, _painter, textborder);
                 }
             }
         }
@@ -343,162 +371,31 @@ void Version::adjustEdgesRecurse()
 
 QString Version::getCommitDateString() const
 {
-    return keyInformation.value("Commit Date", QStringList()).join(QString());
+    return store ? store->getDate(row) : QString();
 }
 
-bool Version::processGitLogInfo(const QString& _input, const QStringList& _parts)
+bool Version::processGitLogInfo(CommitStore* _store, const TagRules& _rules, const QStringList& _parts)
 {
-    // only member, here, all other information is stored in keyInformation
-    hash = _parts.at(1);
+    // the hash selects the row, all information is stored in the commit store
+    store = _store;
+    row = store->insert(ObjectId(_parts.at(1)));
 
     // check if there is new information:
-    if (keyInformation[QString("_input")].join(QString()) == _input)
-        return false;
+    quint64 fingerprint = CommitStore::fingerprint(_parts);
 
-    // erase old information
-    keyInformation.clear();
+    if (store->getFingerprint(row) == fingerprint)
+        return false;
 
-    // store the raw input in the key information, too
-    keyInformation[QString("_input")] = QStringList(_input);
-    keyInformation[QString("Hash")] = QStringList(hash);
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    keyInformation[QString("Commit Date")] =
-        QStringList(
-            QDateTime::fromSecsSinceEpoch(_parts.at(2).toInt())
-            .toString("yyyy.MM.dd HH:mm:ss"));
-#else
-    keyInformation[QString("Commit Date")] =
-        QStringList(
-            QDateTime::fromTime_t(_parts.at(2).toInt())
-            .toString("yyyy.MM.dd HH:mm:ss"));
-#endif
-    commitDate = _parts.at(2).toInt();
-    keyInformation[QString("User Name")] = QStringList(_parts.at(3));
+    // erase old information, the raw input is not stored
+    store->setInput(row, fingerprint, _parts.at(2).toLongLong(), _parts.at(3), _parts.at(4), CommitStore::comment(_parts));
 
     // tag information
-    processGitLogTagInformation(_parts.at(4));
-
-    // commit comment
-    processGitLogCommentInformation(_parts.at(5));
+    _rules.parse(_parts.at(4), store, row);
 
+    // the commit comment is wrapped on demand by the commit store
     return true;
 }
 
-void Version::updateCommentInformation(int _columns, int _maxlen)
-{
-    QStringList& commentRaw = keyInformation[QString("CommentRaw")];
-
-    if (commentRaw.size() == 0)
-        return;
-
-    QString comment = commentRaw.join(" ");
-    QString info = comment;
-
-    if (_maxlen)
-    {
-        info = comment.mid(0, _maxlen);
-        if (comment.size() > _maxlen)
-            info = info + "...";
-    }
-
-    keyInformation[QString("Comment")] = QStringList();
-
-    int len = 0;
-    QString part;
-    QStringList tmp = info.split(' ');
-
-    foreach (const QString& str, tmp)
-    {
-        if (len == 0)
-        {
-            part = str;
-            len = str.size();
-        }
-        else if (_columns == 0 || len < _columns)
-        {
-            part = part + " " + str;
-            len += 1 + str.size();
-        }
-
-        if (_columns && len >= _columns)
-        {
-            keyInformation[QString("Comment")].push_back(part);
-            part = QString();
-            len = 0;
-        }
-    }
-
-    if (len != 0)
-    {
-        keyInformation[QString("Comment")].push_back(part);
-    }
-}
-
-void Version::processGitLogCommentInformation(const QString& _comment)
-{
-    keyInformation[QString("CommentRaw")].push_back(_comment);
-
-    int columns, maxlen;
-
-    graph->getMainWindow()->getCommentProperties(columns, maxlen);
-    updateCommentInformation(columns, maxlen);
-}
-
-void Version::processGitLogTagInformation(const QString& _tagInfo)
-{
-    int cstart = _tagInfo.indexOf(QChar('(')) + 1;
-    int cend = _tagInfo.indexOf(QChar(')'));
-
-    if (cstart >= 0 && cend >= 0)
-    {
-        QStringList matches = _tagInfo.mid(cstart, cend - cstart).split(',');
-        QStringList tags;
-
-        foreach (const QString& str, matches)
-        {
-            tags << str.trimmed();
-        }
-
-        QStringList scanItems (QStringList()
-                               << QString("HEAD")
-                               << changeableVersionInfo
-                               << QString("Other Tags"));
-
-        foreach(const QString& it, scanItems)
-        {
-            const TagPreference* tp =
-                graph->getMainWindow()->getTagPreference(it);
-
-            if (tp)
-            {
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-                QRegularExpression r = tp->getRegExp();
-                foreach (const QString& str, tags)
-                {
-                    QRegularExpressionMatch m = r.match(str);
-
-                    if (m.hasMatch())
-                    {
-                        keyInformation[it].push_back(m.captured(1));
-                        tags.removeOne(str);
-                    }
-                }
-#else
-                QRegExp r = tp->getRegExp();
-                foreach (const QString& str, tags)
-                {
-                    if (r.indexIn(str, 0) != -1)
-                    {
-                        keyInformation[it].push_back(r.cap(1));
-                        tags.removeOne(str);
-                    }
-                }
-#endif
-            }
-        }
-    }
-}
-
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
 bool Version::findMatch(QRegularExpression& _pattern, const QString& _text, bool _exactMatch, QString _keyConstraint)
 #else
@@ -512,40 +409,29 @@ bool Version::findMatch(QRegExp& _pattern, const QString& _text, bool _exactMatc
 
     localVersionInfo.clear();
 
-    QString rawInput = keyInformation["_input"].join(" ")
-        + " " + keyInformation["Commit Date"].join(" ");
-
-#if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
-    bool checkDetail = _pattern.isValid() ? (_pattern.match(rawInput).hasMatch()) :
-        (rawInput.indexOf(_text, 0) != -1);
-#else
-    bool checkDetail = _pattern.isValid() ? (_pattern.indexIn(rawInput, 0) != -1) :
-        (rawInput.indexOf(_text, 0) != -1);
-#endif
+    // the keys are only checked if one of the fields matches
+    bool checkDetail = store && store->matchSearchFields(row, _pattern, _text);
 
     if (checkDetail)
     {
-        for (QMap<QString, QStringList>::iterator kit = keyInformation.begin();
-             kit != keyInformation.end();
-             kit++)
+        foreach (const QString& key, getInformationKeys())
         {
-            if (kit.key() == QString("_input"))
+            if (_keyConstraint.size() && key != _keyConstraint)
                 continue;
 
-            if (_keyConstraint.size() && kit.key() != _keyConstraint)
-                continue;
+            QStringList values = getInformation(key);
 
             if (_exactMatch == true)
             {
-                foreach (const QString& str, kit.value())
+                foreach (const QString& str, values)
                 {
                     if (_keyConstraint.size() && str == _text)
                     {
                         newmatched = true;
-                        if (kit.key() == "CommentRaw")
-                            localVersionInfo.insert("Comment");
+                        if (key == CommitStore::commentRawKey)
+                            localVersionInfo.insert(CommitStore::commentKey);
                         else
-                            localVersionInfo.insert(kit.key());
+                            localVersionInfo.insert(key);
                         break;
                     }
                 }
@@ -554,7 +440,7 @@ bool Version::findMatch(QRegExp& _pattern, const QString& _text, bool _exactMatc
             }
             else
             {
-                QString tmp = kit.value().join(QString(" "));
+                QString tmp = values.join(QString(" "));
 
 #if QT_VERSION >= QT_VERSION_CHECK(5, 0, 0)
                 if ((_pattern.isValid() && _pattern.match(tmp).hasMatch())
@@ -565,10 +451,10 @@ bool Version::findMatch(QRegExp& _pattern, const QString& _text, bool _exactMatc
 #endif
                 {
                     newmatched = true;
-                    if (kit.key() == "CommentRaw")
-                        localVersionInfo.insert("Comment");
+                    if (key == CommitStore::commentRawKey)
+                        localVersionInfo.insert(CommitStore::commentKey);
                     else
-                        localVersionInfo.insert(kit.key());
+                        localVersionInfo.insert(key);
                 }
             }
         }
@@ -599,9 +485,16 @@ void Version::mouseMoveEvent(QGraphicsSceneMouseEvent* _event)
     graph->updateFromToInfo();
 }
 
-const QString& Version::getHash() const
+QString Version::getHash() const
+{
+    return store ? store->getHash(row) : QString();
+}
+
+const ObjectId& Version::getObjectId() const
 {
-    return hash;
+    static const ObjectId null;
+
+    return store ? store->getObjectId(row) : null;
 }
 
 bool Version::getTextBoundingBox(const QString& _key, const QStringList& _values, int& _height, QRectF& _updatedBox) const
@@ -696,13 +589,13 @@ void Version::calculateLocalBoundingBox()
 
     foreach(const QString& info, graph->getMainWindow()->getVersionInfo())
     {
-        if (globalVersionInfo.contains(info)
+        if (globalVersionInfo->contains(info)
             || localVersionInfo.contains(info))
         {
-            QMap<QString, QStringList>::const_iterator kit = keyInformation.find(info);
-            if (kit != keyInformation.end())
+            QStringList values = getInformation(info);
+            if (!values.isEmpty())
             {
-                getTextBoundingBox(kit.key(), kit.value(), height, localBoundingBox);
+                getTextBoundingBox(info, values, height, localBoundingBox);
             }
         }
     }
@@ -920,7 +813,7 @@ void Version::flattenFoldersRecurse()
 
 void Version::updateFoldableRecurse()
 {
-    foldable = graph->getMainWindow()->getVersionIsFoldable(keyInformation);
+    foldable = graph->getMainWindow()->getVersionIsFoldable(getInformationKeys());
 
     foreach (Edge * edge, outEdges)
     {
@@ -1106,14 +999,48 @@ QList<Edge*>& Version::getFileConstraintOutEdgeList()
     return fileConstraintOutEdgeList;
 }
 
-const QMap<QString, QStringList>& Version::getKeyInformation() const
+QStringList Version::getInformationKeys() const
+{
+    return store ? store->getKeys(row) : QStringList();
+}
+
+QStringList Version::getInformation(const QString& _key) const
+{
+    return store ? store->getValues(row, _key) : QStringList();
+}
+
+QMap<QString, QStringList> Version::getKeyInformation() const
+{
+    return store ? store->getKeyInformation(row) : QMap<QString, QStringList>();
+}
+
+const QString& Version::getDecoration() const
+{
+    static const QString empty;
+
+    return store ? store->getDecoration(row) : empty;
+}
+
+CommitStore* Version::getCommitStore() const
+{
+    return store;
+}
+
+int Version::getCommitStoreRow() const
+{
+    return row;
+}
+
+void Version::setCommitStoreRow(CommitStore* _store, int _row)
 {
-    return keyInformation;
+    store = _store;
+    row = _row;
 }
 
-void Version::setKeyInformation(const QMap<QString, QStringList>& _data)
+void Version::setVersionInfo(const QStringList& _globalVersionInfo, const QStringList& _changeableVersionInfo)
 {
-    keyInformation = _data;
+    globalVersionInfo = &_globalVersionInfo;
+    changeableVersionInfo = &_changeableVersionInfo;
 }
 
 bool Version::isSelected() const
@@ -1259,5 +1186,5 @@ int Version::getWeight() const
 
 long Version::getCommitDate() const
 {
-    return commitDate;
+    return store ? long(store->getTime(row)) : 0;
 }
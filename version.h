@@ -34,6 +34,9 @@
 
 #include "node.h"
 
+class CommitStore;
+class ObjectId;
+class TagRules;
 class Edge;
 class GraphWidget;
 QT_BEGIN_NAMESPACE
@@ -81,36 +84,47 @@ public:
     Version* lookupFolderVersion();
     Version* lookupBranchBaseline();
 
-    const QMap<QString, QStringList>& getKeyInformation() const;
+    // keys with information, e.g. "Commit Date" or a tag preference
+    QStringList getInformationKeys() const;
 
-    void setKeyInformation(const QMap<QString, QStringList>& _data);
+    // values of _key, empty if there are none
+    QStringList getInformation(const QString& _key) const;
+
+    // all information, key to values
+    QMap<QString, QStringList> getKeyInformation() const;
+
+    // ref names of git log %d
+    const QString& getDecoration() const;
+
+    CommitStore* getCommitStore() const;
+    int getCommitStoreRow() const;
+
+    // take _row of _store as it is, e.g. restored from a snapshot
+    void setCommitStoreRow(CommitStore* _store, int _row);
+
+    // refer to other lists, e.g. those of the GraphWidget
+    // for a version created by a GitLogWorker
+    void setVersionInfo(const QStringList& _globalVersionInfo, const QStringList& _changeableVersionInfo);
 
     QString getCommitDateString() const;
 
     /**
-     * \brief The git log information _input is checked against
-     *        rawInput. If changed the new tokens of _parts
-     *        are proessed.
+     * \brief The version takes the row of its hash in _store.
+     *        The fingerprint of the git log fields _parts is
+     *        checked against the one of the row. If changed the new
+     *        tokens of _parts are proessed.
      *        _parts contains dummy, hash, commit date, user name and
-     *        tag information.
+     *        tag information. The tags are parsed against _rules.
      *
      * \return If changed true is returned
      */
-    bool processGitLogInfo(const QString& _input, const QStringList& _parts);
-
-
-    /**
-     * \brief The %d information of the git log output is analyzed for
-     *        certain tag patterns.
-     */
-    void processGitLogTagInformation(const QString& _tagInfo);
-    void processGitLogCommentInformation(const QString& _tagInfo);
-    void updateCommentInformation(int _columns, int _maxlen);
+    bool processGitLogInfo(CommitStore* _store, const TagRules& _rules, const QStringList& _parts);
 
     //!> Edges
 
     virtual void addInEdge(Edge* edge);
     virtual void addOutEdge(Edge* edge);
+    void removeEdge(Edge* _edge);
 
     //!> QGraphicsItems
 
@@ -123,10 +137,15 @@ public:
     virtual void setSelected(bool _val);
     virtual bool isSelected() const;
 
-    const QString& getHash() const;
+    // hex string of the object id, empty for the root node
+    QString getHash() const;
+    const ObjectId& getObjectId() const;
 
     QList<Version*> getNeighbourBox();
 
+    // versions linked by an edge, including merges
+    QList<Version*> getAdjacentVersions() const;
+
     void calculateCoordinates(float _scaleX, float _scaleY);
     void linkTreenodes(Version* _parent);
 
@@ -207,25 +226,23 @@ private:
     QList<Edge*> fileConstraintInEdgeList;
     QList<Edge*> fileConstraintOutEdgeList;
 
-    // QString hash;
-    QStringList tags;
-    QStringList branchTags;
     GraphWidget* graph;
 
-    QString commit_sse;
-    const QStringList& globalVersionInfo;
-    const QStringList& changeableVersionInfo;
+    // lists of the GraphWidget, those of the GitLogWorker
+    // while it creates the version
+    const QStringList* globalVersionInfo;
+    const QStringList* changeableVersionInfo;
     static QStringList dummy;
 
     bool matched;
 
-    QMap<QString, QStringList> keyInformation;
+    // the git log information, NULL for the root node
+    CommitStore* store;
+    int row;
+
     QSet<QString> localVersionInfo;
     QRectF localBoundingBox;
     QRectF folderBox;
-    QString treeInfo;
-    QString hash;
-    QDateTime commitTimestamp;
 
     // Versions with no fork or merge are collected in the following list.
     // They can be folded or unfolded, then.
@@ -252,9 +269,6 @@ private:
 
     bool blockItemChanged;
 
-    //
-    QString rawInput;
-
     bool updateBoundingRect;
 
     bool main;
@@ -264,8 +278,6 @@ private:
     bool selected;
 
     int weight;
-
-    long commitDate;
 };
 
 typedef struct Version* VersionPointer;
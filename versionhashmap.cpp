@@ -0,0 +1,113 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#include "versionhashmap.h"
+
+VersionHashMap::VersionHashMap(int _expected) :
+    count(0)
+{
+    reserve(_expected);
+}
+
+void VersionHashMap::reserve(int _expected)
+{
+    // at most half of the slots are used
+    int capacity = 16;
+
+    while (capacity < 2 * _expected)
+        capacity *= 2;
+
+    if (capacity > table.size())
+        rehash(capacity);
+}
+
+int VersionHashMap::find(const ObjectId& _id) const
+{
+    quint32 mask = table.size() - 1;
+    quint32 pos = _id.hashValue() & mask;
+
+    for (;;)
+    {
+        const Entry& entry = table.at(pos);
+
+        if (entry.version == NULL)
+            return pos;
+
+        if (entry.id == _id)
+            return pos;
+
+        pos = (pos + 1) & mask;
+    }
+}
+
+void VersionHashMap::rehash(int _capacity)
+{
+    QVector<Entry> old = table;
+
+    table = QVector<Entry>(_capacity);
+
+    foreach(const Entry& entry, old)
+    {
+        if (entry.version)
+            table[find(entry.id)] = entry;
+    }
+}
+
+void VersionHashMap::insert(const ObjectId& _id, Version* _version)
+{
+    if (2 * (count + 1) > table.size())
+        rehash(2 * table.size());
+
+    Entry& entry = table[find(_id)];
+
+    if (entry.version == NULL)
+    {
+        entry.id = _id;
+        count++;
+    }
+
+    entry.version = _version;
+}
+
+Version* VersionHashMap::value(const ObjectId& _id) const
+{
+    return table.at(find(_id)).version;
+}
+
+QList<Version*> VersionHashMap::values() const
+{
+    QList<Version*> result;
+
+    foreach(const Entry& entry, table)
+    {
+        if (entry.version)
+            result.push_back(entry.version);
+    }
+
+    return result;
+}
+
+int VersionHashMap::size() const
+{
+    return count;
+}
+
+void VersionHashMap::clear()
+{
+    table = QVector<Entry>(16);
+    count = 0;
+}
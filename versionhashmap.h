@@ -0,0 +1,74 @@
+/* --------------------------------------------- */
+/*                                               */
+/*   Copyright (C) 2021 Wolfgang Trummer         */
+/*   Contact: wolfgang.trummer@t-online.de       */
+/*                                               */
+/*                  gvtree V1.9-0                */
+/*                                               */
+/*             git version tree browser          */
+/*                                               */
+/*   28. December 2021                           */
+/*                                               */
+/*         This program is licensed under        */
+/*           GNU GENERAL PUBLIC LICENSE          */
+/*            Version 3, 29 June 2007            */
+/*                                               */
+/* --------------------------------------------- */
+
+#ifndef __VERSIONHASHMAP_H__
+#define __VERSIONHASHMAP_H__
+
+#include <QList>
+#include <QVector>
+
+#include "objectid.h"
+
+class Version;
+
+/**
+ * \brief Map of object ids to versions with open addressing.
+ *        The hashes of git are uniformly distributed, so their
+ *        leading digits are a good hash value and a collision is
+ *        resolved by probing the next slot. The binary ids are
+ *        stored in the table, inserting and looking up an id does
+ *        not allocate.
+ */
+class VersionHashMap
+{
+public:
+    VersionHashMap(int _expected = 0);
+
+    // make room for _expected hashes without rehashing
+    void reserve(int _expected);
+
+    // an existing entry is replaced, _version must not be NULL
+    void insert(const ObjectId& _id, Version* _version);
+
+    // NULL, if _id is unknown
+    Version* value(const ObjectId& _id) const;
+
+    // all versions in no particular order
+    QList<Version*> values() const;
+
+    int size() const;
+    void clear();
+
+private:
+    struct Entry
+    {
+        Entry() : version(NULL) {}
+
+        ObjectId id;
+        Version* version;
+    };
+
+    // slot of _id or the free slot where it belongs
+    int find(const ObjectId& _id) const;
+
+    void rehash(int _capacity);
+
+    QVector<Entry> table;
+    int count;
+};
+
+#endif